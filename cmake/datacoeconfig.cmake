@@ -1,5 +1,6 @@
 include(CMakeFindDependencyMacro)
 
 find_dependency(nlohmann_json REQUIRED)
+find_dependency(Threads REQUIRED)
 
 include("${CMAKE_CURRENT_LIST_DIR}/datacoeTargets.cmake")
\ No newline at end of file
@@ -0,0 +1,421 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace datacoe
+{
+    class ChunkPack; // a chunk pack file of a save, internal
+
+    // Where the elements of a chunk are stored: a blob in one of the save's chunk packs
+    struct ChunkLocation
+    {
+        std::shared_ptr<const ChunkPack> pack; // null until the loaded save is attached to its packs
+        std::uint64_t generation = 0;          // of the pack, 0 if the chunk was never stored
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+        std::uint32_t checksum = 0; // CRC-32 of the blob
+        std::uint8_t flags = 0;     // the WriteOptions the blob was written with
+
+        bool stored() const { return generation != 0; }
+        // true if both refer to the same blob, so their elements are equal without loading them
+        bool sameBlob(const ChunkLocation &other) const;
+    };
+
+    // One chunk of a ChunkedVector, shared by every copy of the vector until one of them changes it
+    // A chunk remembers where it was stored last, so saves skip it as long as it is unchanged
+    class ChunkBase
+    {
+        mutable std::mutex m_mutex; // guards m_location, the digest and the first load of the elements
+        ChunkLocation m_location;
+        mutable std::uint32_t m_digest = 0;
+        mutable bool m_hasDigest = false;
+
+    protected:
+        explicit ChunkBase(ChunkLocation location = ChunkLocation()) : m_location(std::move(location)) {}
+        // a chunk read from a manifest, which lists its digest
+        ChunkBase(ChunkLocation location, std::uint32_t digest) : m_location(std::move(location)), m_digest(digest), m_hasDigest(true) {}
+
+        std::mutex &mutex() const { return m_mutex; }
+        // reads the stored elements as a json array, expects mutex() to be held
+        // throws std::runtime_error if the blob is missing, corrupted or the save's packs were never attached
+        json loadLocked() const;
+        // the elements are about to change, forgets where they were stored and their digest
+        void markChanged();
+
+    public:
+        virtual ~ChunkBase() = default;
+        ChunkBase(const ChunkBase &) = delete;
+        ChunkBase &operator=(const ChunkBase &) = delete;
+
+        virtual std::size_t count() const = 0;
+        virtual bool isLoaded() const = 0;
+        // the elements as a json array, loads them first if needed
+        virtual json elements() const = 0;
+
+        ChunkLocation location() const;
+        void setLocation(ChunkLocation location);
+
+        // CRC-32 of the elements' JSON text, equal chunks have equal digests
+        // Computed once for chunks made in memory, a chunk read from a save has it from the manifest without being loaded
+        std::uint32_t digest() const;
+    };
+
+    // Decides where the chunks of a save go, implemented by the save path of DataReaderWriter
+    class ChunkWriter
+    {
+    public:
+        virtual ~ChunkWriter() = default;
+
+        // The location chunk has in the save being written, queueing its blob if it isn't stored there yet
+        virtual ChunkLocation store(const std::shared_ptr<ChunkBase> &chunk) = 0;
+        // Writes the queued blobs, on success the chunks remember their new locations
+        virtual bool flush(std::string &error) = 0;
+    };
+
+    // The part of ChunkedVector that does not depend on the element type
+    class ChunkedField
+    {
+    protected:
+        std::vector<std::shared_ptr<ChunkBase>> m_chunks;
+        std::size_t m_size = 0;
+
+        ChunkedField() = default;
+        ~ChunkedField() = default;
+        ChunkedField(const ChunkedField &) = default;
+        ChunkedField(ChunkedField &&other) noexcept : m_chunks(std::move(other.m_chunks)), m_size(other.m_size) { other.m_size = 0; }
+        ChunkedField &operator=(const ChunkedField &) = default;
+        ChunkedField &operator=(ChunkedField &&other) noexcept
+        {
+            m_chunks = std::move(other.m_chunks);
+            m_size = other.m_size;
+            other.m_size = 0;
+            return *this;
+        }
+
+        struct StoredChunk
+        {
+            std::size_t count;
+            ChunkLocation location;
+            std::uint32_t digest;
+        };
+
+        // the chunks listed in a manifest, throws std::invalid_argument or json::exception if it is malformed
+        static std::vector<StoredChunk> parseManifest(const json &manifest, std::size_t chunkSize, std::size_t &size);
+
+    public:
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        std::size_t chunkCount() const { return m_chunks.size(); }
+        // chunks that were created in memory or read from the save so far
+        std::size_t loadedChunkCount() const;
+        const std::vector<std::shared_ptr<ChunkBase>> &chunks() const { return m_chunks; }
+
+        // What the save holds instead of the elements when it is written through writer:
+        // {"pack": generation, "size": n, "chunks": [[offset, length, checksum, count, flags, digest], ...]}, or [] when empty
+        json manifest(ChunkWriter &writer) const;
+
+        // Combines the size and the chunk digests, so hashing a loaded save reads none of its chunks
+        std::size_t hash() const;
+
+        // Gives the chunks read from a manifest their pack, openPack(generation) returns null if the pack can't be opened
+        // returns false if one of the packs could not be opened
+        bool attach(const std::function<std::shared_ptr<const ChunkPack>(std::uint64_t generation)> &openPack);
+
+        // Takes over the chunks of previous that hold the same elements, so they keep their stored location
+        // For values rebuilt from json, e.g. a journal replayed on top of a loaded save
+        void adoptUnchanged(const ChunkedField &previous);
+    };
+
+    // A vector field of GameData that is stored in fixed-size chunks next to the save instead of inside it
+    // A load reads only the list of chunks, a chunk is read and decoded the first time one of its elements is accessed,
+    // and a save writes only the chunks that changed since they were loaded or last saved (see DataReaderWriter::writeData())
+    // Copies share their chunks, a change copies just the chunk it touches, so GameData snapshots stay cheap.
+    // Saves encoded without a file (DataReaderWriter::encode(), journal records) hold the elements inline as a plain array,
+    // which is also what toJson() returns and what schema migration steps see for such saves.
+    // Reading an element of a chunk that can't be read (a deleted or corrupted pack) throws std::runtime_error
+    template <class T, std::size_t ChunkSize = 1024>
+    class ChunkedVector : public ChunkedField
+    {
+        static_assert(ChunkSize > 0, "ChunkedVector needs at least one element per chunk");
+
+        class Chunk : public ChunkBase
+        {
+            mutable std::vector<T> m_values;
+            mutable std::atomic<bool> m_loaded;
+            std::size_t m_count;
+
+        public:
+            explicit Chunk(std::vector<T> values) : m_values(std::move(values)), m_loaded(true), m_count(m_values.size()) {}
+            Chunk(std::size_t count, ChunkLocation location, std::uint32_t digest)
+                : ChunkBase(std::move(location), digest), m_loaded(false), m_count(count) {}
+
+            std::size_t count() const override { return m_count; }
+            bool isLoaded() const override { return m_loaded.load(std::memory_order_acquire); }
+            json elements() const override { return json(values()); }
+
+            const std::vector<T> &values() const
+            {
+                if (!m_loaded.load(std::memory_order_acquire))
+                {
+                    std::lock_guard<std::mutex> lock(mutex());
+                    if (!m_loaded.load(std::memory_order_relaxed))
+                    {
+                        std::vector<T> values;
+                        try
+                        {
+                            values = loadLocked().template get<std::vector<T>>();
+                        }
+                        catch (const json::exception &e)
+                        {
+                            throw std::runtime_error(std::string("ChunkedVector chunk holds invalid elements: ") + e.what());
+                        }
+                        if (values.size() != m_count)
+                            throw std::runtime_error("ChunkedVector chunk holds " + std::to_string(values.size()) + " elements instead of " +
+                                                     std::to_string(m_count));
+                        m_values = std::move(values);
+                        m_loaded.store(true, std::memory_order_release);
+                    }
+                }
+                return m_values;
+            }
+
+            // only for a chunk no other vector shares, the change makes it unstored
+            std::vector<T> &modify()
+            {
+                values();
+                markChanged();
+                return m_values;
+            }
+
+            void recount() { m_count = m_values.size(); }
+        };
+
+        const Chunk &chunk(std::size_t index) const { return static_cast<const Chunk &>(*m_chunks[index]); }
+
+        // the chunk at index, copied first if another vector shares it
+        Chunk &writable(std::size_t index)
+        {
+            std::shared_ptr<ChunkBase> &slot = m_chunks[index];
+            if (slot.use_count() != 1)
+                slot = std::make_shared<Chunk>(static_cast<const Chunk &>(*slot).values());
+            return static_cast<Chunk &>(*slot);
+        }
+
+    public:
+        using value_type = T;
+        static constexpr std::size_t CHUNK_SIZE = ChunkSize;
+
+        ChunkedVector() = default;
+
+        ChunkedVector(std::vector<T> values)
+        {
+            m_size = values.size();
+            if (values.size() <= ChunkSize)
+            {
+                if (!values.empty())
+                    m_chunks.push_back(std::make_shared<Chunk>(std::move(values)));
+                return;
+            }
+            for (std::size_t first = 0; first < values.size(); first += ChunkSize)
+            {
+                auto begin = std::make_move_iterator(values.begin() + static_cast<std::ptrdiff_t>(first));
+                auto end = std::make_move_iterator(values.begin() + static_cast<std::ptrdiff_t>(std::min(first + ChunkSize, values.size())));
+                m_chunks.push_back(std::make_shared<Chunk>(std::vector<T>(begin, end)));
+            }
+        }
+
+        ChunkedVector(std::initializer_list<T> values) : ChunkedVector(std::vector<T>(values)) {}
+
+        // Element access loads the element's chunk on first use, the reference is valid until the vector changes
+        const T &operator[](std::size_t index) const { return chunk(index / ChunkSize).values()[index % ChunkSize]; }
+
+        const T &at(std::size_t index) const
+        {
+            if (index >= m_size)
+                throw std::out_of_range("ChunkedVector index " + std::to_string(index) + " is out of range (size " + std::to_string(m_size) + ")");
+            return (*this)[index];
+        }
+
+        const T &back() const { return (*this)[m_size - 1]; }
+
+        void set(std::size_t index, T value)
+        {
+            writable(index / ChunkSize).modify()[index % ChunkSize] = std::move(value);
+        }
+
+        // Changes one element in place, update(T &) may not resize the vector
+        // e.g. inventory.update(3, [](Item &item) { item.count++; });
+        template <typename Function>
+        void update(std::size_t index, Function &&update)
+        {
+            std::forward<Function>(update)(writable(index / ChunkSize).modify()[index % ChunkSize]);
+        }
+
+        void push_back(T value)
+        {
+            if (m_size % ChunkSize == 0)
+            {
+                std::vector<T> values;
+                values.reserve(std::min<std::size_t>(ChunkSize, 16));
+                values.push_back(std::move(value));
+                m_chunks.push_back(std::make_shared<Chunk>(std::move(values)));
+            }
+            else
+            {
+                Chunk &last = writable(m_chunks.size() - 1);
+                last.modify().push_back(std::move(value));
+                last.recount();
+            }
+            m_size++;
+        }
+
+        void pop_back()
+        {
+            if (m_size % ChunkSize == 1 || ChunkSize == 1)
+            {
+                m_chunks.pop_back();
+            }
+            else
+            {
+                Chunk &last = writable(m_chunks.size() - 1);
+                last.modify().pop_back();
+                last.recount();
+            }
+            m_size--;
+        }
+
+        void clear()
+        {
+            m_chunks.clear();
+            m_size = 0;
+        }
+
+        // Calls function(const T &) for every element in order, loading one chunk at a time
+        template <typename Function>
+        void forEach(Function &&function) const
+        {
+            for (std::size_t i = 0; i < m_chunks.size(); i++)
+                for (const T &value : chunk(i).values())
+                    function(value);
+        }
+
+        std::vector<T> toVector() const
+        {
+            std::vector<T> values;
+            values.reserve(m_size);
+            forEach([&values](const T &value)
+                    { values.push_back(value); });
+            return values;
+        }
+
+        // Chunks shared with other or stored in the same blob are equal without being loaded
+        bool operator==(const ChunkedVector &other) const
+        {
+            if (m_size != other.m_size)
+                return false;
+            for (std::size_t i = 0; i < m_chunks.size(); i++)
+            {
+                if (m_chunks[i] == other.m_chunks[i] || m_chunks[i]->location().sameBlob(other.m_chunks[i]->location()))
+                    continue;
+                if (chunk(i).values() != other.chunk(i).values())
+                    return false;
+            }
+            return true;
+        }
+
+        bool operator!=(const ChunkedVector &other) const { return !(*this == other); }
+
+        // Appends the JSON Patch operations from `from` to this vector under pointer to patch, one per changed element,
+        // so a journal record holds only what changed. Chunks the two vectors share are skipped without loading them
+        void diff(const ChunkedVector &from, const std::string &pointer, json &patch) const
+        {
+            json operations = json::array();
+            std::size_t common = std::min(m_size, from.m_size);
+            for (std::size_t first = 0; first < common; first += ChunkSize)
+            {
+                std::size_t index = first / ChunkSize;
+                if (m_chunks[index] == from.m_chunks[index] || m_chunks[index]->location().sameBlob(from.m_chunks[index]->location()))
+                    continue;
+                const std::vector<T> &values = chunk(index).values();
+                const std::vector<T> &fromValues = from.chunk(index).values();
+                for (std::size_t i = 0; first + i < common; i++)
+                {
+                    if (i >= values.size() || i >= fromValues.size())
+                        break;
+                    if (!(values[i] == fromValues[i]))
+                        operations.push_back({{"op", "replace"}, {"path", pointer + "/" + std::to_string(first + i)}, {"value", values[i]}});
+                }
+            }
+            for (std::size_t i = from.m_size; i > m_size; i--)
+                operations.push_back({{"op", "remove"}, {"path", pointer + "/" + std::to_string(i - 1)}});
+            for (std::size_t i = from.m_size; i < m_size; i++)
+                operations.push_back({{"op", "add"}, {"path", pointer + "/-"}, {"value", (*this)[i]}});
+
+            // past that point one replace of the whole array is the smaller record
+            if (operations.size() > m_size / 2 + 1)
+            {
+                patch.push_back({{"op", "replace"}, {"path", pointer}, {"value", *this}});
+                return;
+            }
+            for (json &operation : operations)
+                patch.push_back(std::move(operation));
+        }
+
+        // Restores a ChunkedVector from its manifest, the chunks stay unloaded until the save is attached and they are read
+        void readManifest(const json &manifest)
+        {
+            std::size_t size = 0;
+            std::vector<StoredChunk> stored = parseManifest(manifest, ChunkSize, size);
+            std::vector<std::shared_ptr<ChunkBase>> chunks;
+            chunks.reserve(stored.size());
+            for (StoredChunk &entry : stored)
+                chunks.push_back(std::make_shared<Chunk>(entry.count, std::move(entry.location), entry.digest));
+            m_chunks = std::move(chunks);
+            m_size = size;
+        }
+    };
+
+    // The elements as a plain json array, loading every chunk
+    template <class T, std::size_t ChunkSize>
+    void to_json(json &j, const ChunkedVector<T, ChunkSize> &vector)
+    {
+        j = json::array();
+        j.get_ref<json::array_t &>().reserve(vector.size());
+        vector.forEach([&j](const T &value)
+                       { j.push_back(value); });
+    }
+
+    // Accepts the plain array of to_json() and the manifest of ChunkedField::manifest()
+    template <class T, std::size_t ChunkSize>
+    void from_json(const json &j, ChunkedVector<T, ChunkSize> &vector)
+    {
+        if (j.is_array())
+            vector = ChunkedVector<T, ChunkSize>(j.get<std::vector<T>>());
+        else
+            vector.readManifest(j);
+    }
+} // namespace datacoe
+
+namespace std
+{
+    template <class T, std::size_t ChunkSize>
+    struct hash<datacoe::ChunkedVector<T, ChunkSize>>
+    {
+        std::size_t operator()(const datacoe::ChunkedVector<T, ChunkSize> &vector) const { return vector.hash(); }
+    };
+} // namespace std
\ No newline at end of file
@@ -1,39 +1,290 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <utility>
+#include "data_reader_writer.hpp"
 #include "game_data.hpp"
 
 namespace datacoe
 {
+    class SaveWorker;
+    class Journal;
+    class DataManager;
+
+    // Auto-save schedule, see DataManager::enableAutoSave()
+    struct AutoSaveOptions
+    {
+        // minimum time between two auto-saves
+        std::chrono::milliseconds interval = std::chrono::seconds(30);
+        // changes are written once GameData has been left alone this long, so bursts of setGamedata() become one write
+        std::chrono::milliseconds debounce = std::chrono::seconds(2);
+        // unsaved changes older than this are written right away, ignoring debounce and interval
+        std::chrono::milliseconds maxStaleness = std::chrono::seconds(60);
+        // true runs the schedule on a timer thread owned by the DataManager, false leaves it to tick() from the game loop
+        bool backgroundTimer = false;
+    };
+
+    // Journal mode limits, see DataManager::enableJournal()
+    struct JournalOptions
+    {
+        // the save file is rewritten (compacted) once the journal holds this many records
+        std::size_t maxRecords = 100;
+        // or once the journal has grown to this fraction of the save file's size
+        double maxSizeRatio = 1.0;
+    };
+
+    // Progress, cancellation and result of one background load, see DataManager::loadGameAsync()
+    // Copies refer to the same load
+    class LoadTask
+    {
+    public:
+        struct State
+        {
+            std::atomic<float> progress{0.0f};
+            std::atomic<bool> cancelRequested{false};
+            std::atomic<bool> cancelled{false};
+            std::atomic<bool> readDone{false}; // the load thread is done, the result waits for the owning thread
+            // the rest belongs to the owning thread
+            DataManager *owner = nullptr; // cleared once the result is applied or the load is stopped
+            bool finished = false;
+            std::promise<bool> result;
+        };
+
+    private:
+        std::shared_ptr<State> m_state;
+        std::shared_future<bool> m_result;
+
+    public:
+        LoadTask() = default;
+        LoadTask(std::shared_ptr<State> state, std::shared_future<bool> result);
+
+        // 0 to 1, advances with the bytes read, decryption and parsing are one step near the end
+        float getProgress() const;
+        // poll from the game loop, true once the result is available, applies a finished load to the DataManager
+        bool isReady() const;
+        // waits for the load and applies it, true if it loaded the save (what loadGame() would return), false if it failed or was cancelled
+        bool get() const;
+        // the result for other threads that want to wait or chain on it, ready once the owning thread applied the load
+        std::shared_future<bool> getFuture() const;
+
+        // asks the load to stop at its next checkpoint (between file chunks, before decoding, before applying)
+        // a load that stops leaves the current GameData untouched
+        void cancel();
+        // true if the load stopped because of cancel() (or a newer change), false if it was applied first
+        bool isCancelled() const;
+    };
+
+    // Mutators take an internal lock, so they can be called from any thread (including the auto-save timer).
+    // getGamedata() is for the thread that owns the DataManager, other threads (HUD, UI) read
+    // through getSnapshot(), which never blocks on a save or load in progress
     class DataManager
     {
         std::string m_filename;
         GameData m_gamedata;
+        mutable std::shared_ptr<const GameData> m_snapshot; // Immutable copy of m_gamedata, replaced (never modified) once it is stale
+        mutable std::atomic<bool> m_snapshotStale{false}; // m_gamedata changed since m_snapshot was copied from it
         bool m_encrypt = true;             // Whether to use encryption
-        bool m_fileEncrypted = false;       // Whether the file is currently encrypted
+        std::atomic<bool> m_fileEncrypted{false}; // Whether the file is currently encrypted, also set by the background writer
+        Durability m_durability = Durability::None; // How saveGame() flushes the file to disk
+        std::size_t m_mmapThreshold = ReadOptions::DEFAULT_MMAP_THRESHOLD; // Saves of at least this size are memory-mapped on load
+        SerializationFormat m_format = SerializationFormat::Json; // Encoding used by saveGame(), loadGame() detects it
+        Compression m_compression = Compression::None; // Compression used by saveGame(), loadGame() detects it
+        std::atomic<std::uint64_t> m_generation{0}; // Bumped on every change that alters what saveGame() would write
+        std::atomic<std::uint64_t> m_savedGeneration{0}; // Generation last written or loaded, also set by the background writer
+        std::atomic<std::size_t> m_skippedSaves{0}; // saveGame()/saveGameAsync() calls skipped because nothing changed
+
+        // Journal mode state, the journal is used by whichever thread writes the save (saveGame() caller or background writer)
+        bool m_journalEnabled = false;
+        JournalOptions m_journalOptions;
+        std::unique_ptr<Journal> m_journal;
+        std::atomic<std::size_t> m_compactions{0};
+        std::mutex m_journalMutex; // Guards m_journal and m_journalOptions, taken after m_mutex when both are held
+
+        // The background load of loadGameAsync(), one at a time
+        // The thread only reads, its result waits in m_loadedSave until the owning thread applies it
+        struct LoadedSave
+        {
+            std::optional<GameData> gamedata;
+            SaveInfo info;
+            bool newGameOnFailure = false;
+        };
+        std::thread m_loadThread;
+        std::shared_ptr<LoadTask::State> m_loadState;
+        std::optional<LoadedSave> m_loadedSave;
+
+        std::unique_ptr<SaveWorker> m_saveWorker; // Background writer of saveGameAsync(), declared after the state it writes so it is destroyed first
+
+        // Auto-save state
+        AutoSaveOptions m_autoSave;
+        bool m_autoSaveEnabled = false;
+        bool m_autoSaveStop = false;
+        std::atomic<std::size_t> m_autoSaves{0};
+        std::chrono::steady_clock::time_point m_lastAutoSave;
+        std::chrono::steady_clock::time_point m_lastChange;
+        std::optional<std::chrono::steady_clock::time_point> m_unsavedSince; // oldest change no save has picked up yet
+        std::condition_variable m_autoSaveWakeup;
+        std::thread m_autoSaveThread;
+
+        // Guards the state the auto-save timer thread reads, the owning thread takes it in every mutator
+        mutable std::mutex m_mutex;
+
+        // the *Locked methods expect m_mutex to be held
+        std::future<bool> saveGameAsyncLocked();
+        // hands the current snapshot to the background writer, no skipping
+        std::future<bool> submitSaveLocked();
+        void markDirtyLocked();
+        // marks the snapshot stale, the copy is made by the next getSnapshot() or save instead of every change
+        void publishLocked();
+        // the snapshot of the current m_gamedata, copies it first if the snapshot is stale
+        std::shared_ptr<const GameData> snapshotLocked() const;
+        bool autoSaveLocked(std::chrono::steady_clock::time_point now);
+        // true (and counted) if the save can be skipped because the file already holds the current state
+        bool skipUnchangedSave();
+        // The write behind every save: a journal record in journal mode, otherwise (or when compacting) the whole file
+        // background is true on the background writer, which compacts right away instead of handing it off
+        bool writeSave(const GameData &gamedata, const std::string &filename, const WriteOptions &options, bool journal, bool background);
+        // true if the open journal reached a JournalOptions limit, expects m_journalMutex to be held
+        bool compactionDue();
+        // Reads the save and replays its journal, onProgress is passed to the file read
+        std::optional<GameData> readSave(const std::string &filename, const ReadOptions &options, SaveInfo &info,
+                                         const std::function<bool(std::size_t, std::size_t)> &onProgress);
+        // makes loaded data the current GameData, returns whether there was any
+        // a save of an older schema version, or stored differently than the manager stores it, stays dirty
+        bool applyLoadedLocked(std::optional<GameData> loadedGamedata, const SaveInfo &info);
+        // cancels and joins the running loadGameAsync(), if any
+        void stopAsyncLoad();
+        // newGameOnFailure gives initAsync() the behavior of init()
+        LoadTask startAsyncLoad(bool newGameOnFailure);
+        // on the owning thread, applies (or drops, if cancelled) the finished load of state
+        // returns false if the load is still reading and wait is false
+        bool finishAsyncLoad(LoadTask::State &state, bool wait);
+        // a change made while a load is in flight wins over the load
+        void cancelAsyncLoadLocked();
+        void newGameLocked();
+        friend class LoadTask;
 
     public:
         // Users should add or modify constructors and destructor as needed
-        DataManager() = default;
-        ~DataManager() = default;
+        DataManager();
+        // cancels a running loadGameAsync(), stops auto-saving and waits for pending saveGameAsync() writes
+        ~DataManager();
 
         // Users should modify the initialization to match their own game
         // returns true if succeed to load, or false if needs to start a new game
-        bool init(const std::string filename, bool encrypt = true); 
+        bool init(std::string filename, bool encrypt = true);
 
         // Users should modify those methods to match their own game
         bool saveGame();
         bool loadGame();
 
+        // init() and loadGame() on a background thread, so startup doesn't wait for disk I/O, decryption and parsing
+        // The result replaces the current GameData on the owning thread, in the first tick(), LoadTask::isReady() or
+        // LoadTask::get() after the load finishes (initAsync() starts a new game if it fails), so getGamedata() never
+        // changes underneath the game. Starting a load, init(), loadGame() and any GameData change cancel a load not applied yet
+        LoadTask initAsync(std::string filename, bool encrypt = true);
+        LoadTask loadGameAsync();
+
+        // Saves a copy of the current GameData on a background thread, the future holds the saveGame() result
+        // Requests made while a write is in flight are collapsed into one write of the newest GameData
+        std::future<bool> saveGameAsync();
+        // blocks until all saveGameAsync() requests are on disk, saveGame() and loadGame() call it first
+        void waitForPendingSaves();
+        // number of saveGameAsync() requests that were superseded by a newer one instead of being written
+        std::size_t getCoalescedSaveCount() const;
+
+        // Auto-save, writes through saveGameAsync() so the calling thread never waits for the disk
+        // A save starts once the changes have settled for options.debounce and options.interval has passed
+        // since the previous auto-save, or right away when the oldest unsaved change is options.maxStaleness old
+        void enableAutoSave(const AutoSaveOptions &options = AutoSaveOptions());
+        void disableAutoSave();
+        bool isAutoSaveEnabled() const;
+        // game-loop hook, cheap enough to call every frame, returns true if it started an auto-save
+        // (not needed with options.backgroundTimer, but harmless), also applies a finished loadGameAsync()
+        bool tick();
+        // number of auto-saves started so far
+        std::size_t getAutoSaveCount() const;
+
+        // Journal mode, for large GameData that changes a little between saves
+        // Saves append the changes since the previous save as a small (encrypted) record to <filename>.journal
+        // instead of rewriting the file, the file is rewritten on the background writer once the journal
+        // reaches a JournalOptions limit. loadGame() replays the journal whether or not journal mode is enabled
+        void enableJournal(const JournalOptions &options = JournalOptions());
+        // the next save rewrites the file and deletes the journal
+        void disableJournal();
+        bool isJournalEnabled() const;
+        // number of times a full journal was folded back into the save file
+        std::size_t getCompactionCount() const;
+
         // Users should modify this method to match their own game
         void newGame();
 
         // GameData specific methods, Users should modify to match their own game
         void setGamedata(const GameData &gamedata);
+        // takes over the strings of gamedata instead of copying them
+        void setGamedata(GameData &&gamedata);
+        // Changes the current GameData in place, update(GameData &) runs under the internal lock
+        // e.g. dm.updateGamedata([](GameData &gd) { gd.setHighscore(gd.getHighscore() + 10); });
+        template <typename Function>
+        void updateGamedata(Function &&update)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            cancelAsyncLoadLocked();
+            std::forward<Function>(update)(m_gamedata);
+            publishLocked();
+            markDirtyLocked();
+        }
+        // Replaces the current GameData with one built from GameData constructor arguments
+        template <typename... Args>
+        void emplaceGamedata(Args &&...args)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            cancelAsyncLoadLocked();
+            m_gamedata = GameData(std::forward<Args>(args)...);
+            publishLocked();
+            markDirtyLocked();
+        }
         const GameData &getGamedata() const;
+        // Lock-free read of the latest GameData, safe from any thread while others save, load or set data
+        // The snapshot never changes, hold on to it as long as needed and call again for newer data
+        // The first call after a change takes the lock and copies GameData once, later calls until the next change only load a pointer.
+        // saveGame() and loadGame() copy a stale snapshot before their I/O, so a reader never waits for the disk
+        std::shared_ptr<const GameData> getSnapshot() const;
+
+        // Dirty tracking, saveGame() and saveGameAsync() return true without writing when nothing changed since the last save or load
+        // Users adding methods that modify m_gamedata in place should call markDirty()
+        bool isDirty() const;
+        void markDirty();
+        std::size_t getSkippedSaveCount() const;
 
         // Encryption related methods
         bool isEncrypted() const;
         void setEncryption(bool encrypt);
+
+        // Durability of saveGame(), e.g. Durability::None for autosaves and Durability::Full for quit-saves
+        void setDurability(Durability durability);
+        Durability getDurability() const;
+
+        // Encoding of new saves, loadGame() reads every format regardless of this setting
+        void setSerializationFormat(SerializationFormat format);
+        SerializationFormat getSerializationFormat() const;
+
+        // Compression of new saves, loadGame() reads every codec regardless of this setting
+        void setCompression(Compression compression);
+        Compression getCompression() const;
+
+        // Load tuning, saves of at least this many bytes are decoded straight from a memory mapping
+        void setMmapThreshold(std::size_t bytes);
+        std::size_t getMmapThreshold() const;
     };
 } // namespace datacoe
\ No newline at end of file
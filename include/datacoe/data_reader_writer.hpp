@@ -1,20 +1,149 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <optional>
+#include <utility>
+#include <vector>
 #include "game_data.hpp"
 
 namespace datacoe
 {
+    struct ReadOptions
+    {
+        static constexpr std::size_t DEFAULT_MMAP_THRESHOLD = 1024 * 1024;
+
+        bool decryption = true;
+        // Files of at least this many bytes are decoded straight from a read-only memory mapping,
+        // smaller files are read into a single heap buffer
+        std::size_t mmapThreshold = DEFAULT_MMAP_THRESHOLD;
+    };
+
+    // How hard writeData() works to get a save onto stable storage before returning
+    // Every level writes to a temporary file and renames it over the save, so a crash
+    // never leaves a partially written file, the levels differ only in power-loss safety
+    enum class Durability
+    {
+        None, // no explicit flush, cheapest, for frequent autosaves
+        Data, // fdatasync() the file contents before the rename
+        Full  // fsync() the file and its directory, for quit-saves that must survive power loss
+    };
+
+    // Encoding of GameData inside a save, recorded in the file and detected on load
+    // Json is human-readable when encryption is off, the binary formats are smaller and faster to parse
+    // The values are stored in save files, never renumber them
+    enum class SerializationFormat
+    {
+        Json = 0,
+        Cbor = 1,
+        MessagePack = 2,
+        Bson = 3
+    };
+
+    // Compression of the serialized GameData, applied before encryption since ciphertext does not compress
+    // Fast is a lightweight LZ codec that costs less than the disk and AES work it saves, High is Deflate
+    // The codec is recorded in the file and detected on load, the values are stored in save files, never renumber them
+    enum class Compression
+    {
+        None = 0,
+        Fast = 1,
+        High = 2
+    };
+
+    struct WriteOptions
+    {
+        bool encryption = true;
+        Durability durability = Durability::None;
+        SerializationFormat format = SerializationFormat::Json;
+        Compression compression = Compression::None;
+    };
+
+    // How a save is stored, filled in by DataReaderWriter::decode()
+    struct SaveInfo
+    {
+        bool encrypted = false;
+        // AES-CBC and Base64 saves still load but are no longer written
+        bool legacyEncryption = false;
+        SerializationFormat format = SerializationFormat::Json;
+        Compression compression = Compression::None;
+        // the GameData schema version the save was written with, before any migration
+        int schemaVersion = GameData::SCHEMA_VERSION;
+
+        // true if writing the save with options would store it the same way
+        // a save too small to shrink is stored uncompressed, so it never matches options that ask for compression
+        bool matches(const WriteOptions &options) const;
+    };
+
     // No need to modify
     class DataReaderWriter
     {
-        static std::string encrypt(const std::string &data);
-        static std::string decrypt(const std::string &encodedData);
+        static std::string encrypt(std::string_view data, std::uint16_t flags, std::string_view summary = std::string_view());
+        static std::string decrypt(std::string_view fileData);
+        static std::string decryptAesGcm(std::string_view header, std::string_view payload);
+        static bool decryptAesCbcInPlace(std::string &buffer);
+        static bool isEncryptedData(std::string_view data);
+
+        // The bytes of a save holding document: serialized, compressed and encrypted as options say
+        // summary (optional) goes into the separately readable summary block of a container
+        static std::optional<std::string> encodeDocument(const json &document, const WriteOptions &options, const json *summary = nullptr);
+        // Reverses encodeDocument() up to the serialized data, which payload views (in data or in buffer)
+        // info receives how data is stored, except its schema version
+        static bool unwrap(std::string_view data, bool decryption, SaveInfo &info, std::string &buffer, std::string_view &payload);
+        // the document encodeDocument() was given, std::nullopt if data is unreadable
+        static std::optional<json> decodeDocument(std::string_view data, bool decryption);
+
+        // the summary fields of a save with a current summary block, hasSummary is false for saves that have to be decoded whole
+        // data has to hold the header and the summary block, the rest of the save may be missing
+        static std::optional<GameData> decodeSummaryBlock(std::string_view data, bool &hasSummary);
+
+        friend class ChunkStore; // chunk blobs are encoded like saves
 
     public:
+        // true if the CPU has the AES and carry-less multiply instructions CryptoPP uses for AES-GCM
+        static bool isHardwareAccelerated();
+
         static bool isFileEncrypted(const std::string &filename);
+        // GameData with ChunkedVector fields keeps their chunks next to the save in <filename>.chunks0/1, and only writes
+        // the chunks that are not stored there yet, readData() loads the chunks on first access
         static bool writeData(const GameData &gamedata, const std::string &filename, bool encryption = true);
-        static std::optional<GameData> readData(const std::string &filename, bool decryption = true);
+        static bool writeData(const GameData &gamedata, const std::string &filename, const WriteOptions &options);
+        // fileEncrypted (optional) receives the detected file format, so callers don't need a separate isFileEncrypted() call
+        static std::optional<GameData> readData(const std::string &filename, bool decryption = true, bool *fileEncrypted = nullptr);
+        static std::optional<GameData> readData(const std::string &filename, const ReadOptions &options, bool *fileEncrypted = nullptr);
+
+        // Summary read for save menus: a GameData with only the fields of GameData::summaryFields() set, the others default
+        // Saves keep those fields in a small block after the container header, encrypted on its own, so only the first
+        // SUMMARY_READ_SIZE bytes are read and decrypted. Plain JSON files, saves whose summary does not fit and saves from
+        // before the summary block or of an older schema version are decoded whole. Like readData(), a journal next to
+        // the save is not applied
+        static std::optional<GameData> readSummary(const std::string &filename, bool decryption = true);
+        // the in-memory half of readSummary(), for bytes already loaded
+        static std::optional<GameData> decodeSummary(std::string_view fileData, bool decryption = true);
+        // the container header and the summary block have to fit in this many bytes, or the save has no summary block
+        static constexpr std::size_t SUMMARY_READ_SIZE = 512;
+
+        // The in-memory halves of writeData() and readData(), for callers that handle the file themselves
+        // encode() returns the bytes of a self-contained save, std::nullopt on failure. ChunkedVector fields are stored inline
+        // unless chunks is given, which stores them (see chunked_vector.hpp) and leaves their manifests in the save
+        static std::optional<std::string> encode(const GameData &gamedata, const WriteOptions &options, ChunkWriter *chunks = nullptr);
+        // info (optional) receives how the save is stored and its schema version, also when decoding it fails after the header
+        // ChunkedVector fields a save keeps in its chunk packs are not attached to them, reading their elements throws,
+        // readData() attaches them
+        static std::optional<GameData> decode(std::string_view fileData, const ReadOptions &options, SaveInfo *info = nullptr);
+
+        // Batch writeData() and readData() for tools that process many saves, spread over threads (0 = one per core)
+        // Every item succeeds or fails on its own, results are in the order of the input
+        static std::vector<bool> writeMany(const std::vector<std::pair<GameData, std::string>> &jobs,
+                                           const WriteOptions &options = WriteOptions(), std::size_t threads = 0);
+        static std::vector<std::optional<GameData>> readMany(const std::vector<std::string> &filenames,
+                                                             const ReadOptions &options = ReadOptions(), std::size_t threads = 0);
+
+        // Rewrites the saves among filenames that are older than GameData::SCHEMA_VERSION, so their migration runs once
+        // instead of on every load. Up-to-date saves are only read, saves with a journal are left to DataManager.
+        // Spread over threads like writeMany(), true for every save that is up to date afterwards
+        static std::vector<bool> upgradeMany(const std::vector<std::string> &filenames,
+                                             const WriteOptions &options = WriteOptions(), std::size_t threads = 0);
     };
 } // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,543 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "chunked_vector.hpp"
+#include "inline_string.hpp"
+
+using json = nlohmann::json;
+
+namespace datacoe
+{
+    // Compile-time field lists: a class names its fields once, as constexpr descriptors of a key and a member pointer,
+    // and the templates below generate JSON conversion, streaming parsing, JSON Patch diffs, equality and hashing from it.
+    // Every walk over the fields is a fold expression the compiler unrolls, keys are compared against the literals
+    // in the list, there is no table of keys built at runtime.
+    //
+    //     class Player
+    //     {
+    //         std::string m_name;
+    //         int m_level = 0;
+    //
+    //     public:
+    //         static constexpr auto fields()
+    //         {
+    //             return std::make_tuple(field("name", &Player::m_name), field("level", &Player::m_level));
+    //         }
+    //     };
+    //
+    // The class has to be default constructible. bool, integer, floating point, std::string and InlineString fields are filled
+    // straight from the parser, any other type nlohmann::json can convert (containers, enums, structs with to_json()/from_json())
+    // is collected into a small json value first. ChunkedVector fields are saved as a manifest of their chunks when toJson()
+    // gets a ChunkWriter, and their diff() lists changed elements instead of the whole array
+    template <class Owner, class T>
+    struct FieldDescriptor
+    {
+        using value_type = T;
+
+        std::string_view key;
+        T Owner::*member;
+    };
+
+    template <class Owner, class T>
+    constexpr FieldDescriptor<Owner, T> field(std::string_view key, T Owner::*member)
+    {
+        return FieldDescriptor<Owner, T>{key, member};
+    }
+
+    namespace reflection
+    {
+        template <class Owner>
+        inline constexpr auto fieldList = Owner::fields();
+
+        template <class Owner>
+        inline constexpr std::size_t fieldCount = std::tuple_size_v<std::decay_t<decltype(fieldList<Owner>)>>;
+
+        template <class Field>
+        using FieldType = typename std::decay_t<Field>::value_type;
+
+        template <class T>
+        inline constexpr bool isString = std::is_same_v<T, std::string>;
+
+        template <class T>
+        struct IsInlineString : std::false_type
+        {
+        };
+
+        template <std::size_t Capacity>
+        struct IsInlineString<InlineString<Capacity>> : std::true_type
+        {
+        };
+
+        template <class T>
+        inline constexpr bool isInlineString = IsInlineString<T>::value;
+
+        // the types read straight from the parser's events
+        template <class T>
+        inline constexpr bool isScalar = std::is_arithmetic_v<T> || isString<T> || isInlineString<T>;
+
+        template <class T>
+        inline constexpr bool isChunked = std::is_base_of_v<ChunkedField, T>;
+
+        template <class Fields>
+        struct AnyChunked;
+
+        template <class... Fields>
+        struct AnyChunked<std::tuple<Fields...>> : std::bool_constant<(isChunked<FieldType<Fields>> || ...)>
+        {
+        };
+
+        template <class Owner>
+        inline constexpr bool hasChunkedFields = AnyChunked<std::decay_t<decltype(fieldList<Owner>)>>::value;
+
+        template <class T, class = void>
+        struct HasStdHash : std::false_type
+        {
+        };
+
+        template <class T>
+        struct HasStdHash<T, std::void_t<decltype(std::hash<T>{}(std::declval<const T &>()))>> : std::true_type
+        {
+        };
+
+        // calls function(descriptor) for every field, in the order of the list
+        template <class Owner, class Function>
+        void forEachField(Function &&function)
+        {
+            std::apply([&function](const auto &...fields)
+                       { (function(fields), ...); },
+                       fieldList<Owner>);
+        }
+
+        // calls function(descriptor) for the field at a runtime index
+        template <class Owner, class Function>
+        void visitField(std::size_t index, Function &&function)
+        {
+            std::apply([&function, index](const auto &...fields)
+                       {
+                std::size_t i = 0;
+                ((i++ == index ? (function(fields), true) : false) || ...); },
+                       fieldList<Owner>);
+        }
+
+        // calls function(field) for every ChunkedVector field of object, a ChunkedField & (const if object is)
+        template <class Owner, class Function>
+        void forEachChunkedField(Owner &object, Function &&function)
+        {
+            forEachField<std::remove_const_t<Owner>>([&](const auto &field)
+                                                     {
+                if constexpr (isChunked<FieldType<decltype(field)>>)
+                    function(object.*field.member); });
+        }
+
+        // index of the field named key, fieldCount<Owner> if there is none
+        template <class Owner>
+        std::size_t findField(std::string_view key)
+        {
+            std::size_t index = 0;
+            std::apply([&index, key](const auto &...fields)
+                       { ((fields.key == key ? true : (index++, false)) || ...); },
+                       fieldList<Owner>);
+            return index;
+        }
+
+        inline std::runtime_error invalidField(std::string_view key)
+        {
+            return std::runtime_error("'" + std::string(key) + "' key is missing or invalid in the JSON object we are trying to load.");
+        }
+
+        // true if j has the JSON type a field of type T is stored as, other types are checked by their from_json()
+        template <class T>
+        bool holds(const json &j)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                return j.is_boolean();
+            else if constexpr (std::is_integral_v<T>)
+                return j.is_number_integer();
+            else if constexpr (std::is_floating_point_v<T>)
+                return j.is_number();
+            else if constexpr (isString<T>)
+                return j.is_string();
+            else if constexpr (isInlineString<T>)
+                return j.is_string() && T::fits(j.get_ref<const std::string &>()); // too long is as invalid as the wrong type
+            else
+                return true;
+        }
+
+        // JSON Pointer (RFC 6901) of a top-level key
+        inline std::string pointerTo(std::string_view key)
+        {
+            std::string pointer = "/";
+            for (char c : key)
+            {
+                if (c == '~')
+                    pointer += "~0";
+                else if (c == '/')
+                    pointer += "~1";
+                else
+                    pointer += c;
+            }
+            return pointer;
+        }
+
+        // chunks (optional) stores ChunkedVector fields and puts their manifests in j, without it they are plain arrays
+        template <class Owner>
+        json toJson(const Owner &object, ChunkWriter *chunks = nullptr)
+        {
+            json j = json::object();
+            forEachField<Owner>([&](const auto &field)
+                                {
+                if constexpr (isChunked<FieldType<decltype(field)>>)
+                {
+                    if (chunks)
+                    {
+                        j[std::string(field.key)] = (object.*field.member).manifest(*chunks);
+                        return;
+                    }
+                }
+                j[std::string(field.key)] = object.*field.member; });
+            return j;
+        }
+
+        // Throws std::runtime_error naming the first missing or mistyped field, or json::exception from another type's from_json()
+        // Strings are moved out of j when it is an rvalue
+        template <class Owner, class Json>
+        Owner fromJson(Json &&j)
+        {
+            Owner object;
+            forEachField<Owner>([&](const auto &field)
+                                {
+                using T = FieldType<decltype(field)>;
+                auto it = j.find(field.key);
+                if (it == j.end() || !holds<T>(*it))
+                    throw invalidField(field.key);
+
+                if constexpr (isString<T> && !std::is_reference_v<Json>)
+                    object.*field.member = std::move(it->template get_ref<std::string &>());
+                else
+                    object.*field.member = it->template get<T>(); });
+            return object;
+        }
+
+        // The summary fields, Owner::summaryFields() lists a few of its fields() to be stored again where they are quick to read
+        template <class Owner>
+        json summaryToJson(const Owner &object)
+        {
+            json j = json::object();
+            std::apply([&](const auto &...fields)
+                       { ((j[std::string(fields.key)] = object.*fields.member), ...); },
+                       Owner::summaryFields());
+            return j;
+        }
+
+        // one field of summaryFromJson()
+        template <class Owner, class Field>
+        void readSummaryField(const json &j, const Field &field, Owner &object)
+        {
+            using T = FieldType<Field>;
+            static_assert(!isChunked<T>, "A summary field can't be a ChunkedVector");
+            auto it = j.find(field.key);
+            if (it == j.end() || !holds<T>(*it))
+                throw invalidField(field.key);
+            object.*field.member = it->template get<T>();
+        }
+
+        // Fills the summary fields of object from j, throws like fromJson()
+        template <class Owner>
+        void summaryFromJson(const json &j, Owner &object)
+        {
+            std::apply([&](const auto &...fields)
+                       { (readSummaryField(j, fields, object), ...); },
+                       Owner::summaryFields());
+        }
+
+        template <class Owner>
+        bool equal(const Owner &a, const Owner &b)
+        {
+            return std::apply([&](const auto &...fields)
+                              { return ((a.*fields.member == b.*fields.member) && ...); },
+                              fieldList<Owner>);
+        }
+
+        // Combines the std::hash of every field, a field type without one is hashed through its JSON text
+        // ChunkedVector has one (ChunkedField::hash()), so hashing never loads its chunks
+        template <class Owner>
+        std::size_t hash(const Owner &object)
+        {
+            std::size_t seed = 0;
+            forEachField<Owner>([&](const auto &field)
+                                {
+                using T = FieldType<decltype(field)>;
+                std::size_t value;
+                if constexpr (HasStdHash<T>::value)
+                    value = std::hash<T>{}(object.*field.member);
+                else
+                    value = std::hash<std::string>{}(json(object.*field.member).dump());
+                seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); });
+            return seed;
+        }
+
+        // JSON Patch (RFC 6902) that turns from into to, one "replace" of the whole value per changed field,
+        // per changed element for ChunkedVector fields
+        template <class Owner>
+        json diff(const Owner &from, const Owner &to)
+        {
+            json patch = json::array();
+            forEachField<Owner>([&](const auto &field)
+                                {
+                if constexpr (isChunked<FieldType<decltype(field)>>)
+                    (to.*field.member).diff(from.*field.member, pointerTo(field.key), patch);
+                else if (!(from.*field.member == to.*field.member))
+                    patch.push_back({{"op", "replace"}, {"path", pointerTo(field.key)}, {"value", to.*field.member}}); });
+            return patch;
+        }
+
+        // Lets the ChunkedVector fields of object take over the unchanged chunks of previous, see ChunkedField::adoptUnchanged()
+        template <class Owner>
+        void adoptUnchangedChunks(Owner &object, const Owner &previous)
+        {
+            forEachField<Owner>([&](const auto &field)
+                                {
+                if constexpr (isChunked<FieldType<decltype(field)>>)
+                    (object.*field.member).adoptUnchanged(previous.*field.member); });
+        }
+
+        // SAX handler for json::sax_parse() that writes the fields of Owner as the parser reports them, for every input format
+        // Only values directly inside the top-level object are looked at, anything nested under an unknown key is skipped
+        template <class Owner>
+        class SaxReader
+        {
+            static constexpr std::size_t NONE = fieldCount<Owner>;
+
+            Owner &m_object;
+            std::array<bool, fieldCount<Owner>> m_valid{};
+            std::size_t m_depth = 0;
+            std::size_t m_field = NONE;
+
+            // a top-level value outside the field list that the caller wants to see, e.g. a schema version
+            std::string_view m_extraKey;
+            json m_extra;
+            bool m_atExtra = false;
+
+            // the nested value of a field that is not a scalar, converted once it is complete
+            json m_capture;
+            std::vector<json *> m_captureStack;
+            std::string m_captureKey;
+
+            // true while the parser is at a value of the top-level object under a known key
+            bool atField() const { return m_depth == 1 && m_field != NONE; }
+            bool capturing() const { return !m_captureStack.empty(); }
+
+            bool atScalarField()
+            {
+                bool scalar = false;
+                visitField<Owner>(m_field, [&scalar](const auto &field)
+                                  { scalar = isScalar<FieldType<decltype(field)>>; });
+                return scalar;
+            }
+
+            void invalidate()
+            {
+                if (atField())
+                    m_valid[m_field] = false;
+            }
+
+            json *insert(json value)
+            {
+                json &parent = *m_captureStack.back();
+                if (parent.is_array())
+                {
+                    parent.push_back(std::move(value));
+                    return &parent.back();
+                }
+                json &slot = parent[m_captureKey];
+                slot = std::move(value);
+                return &slot;
+            }
+
+            // a value from_json() can't convert invalidates the field instead of aborting the parse
+            template <class T>
+            static bool convert(T &target, const json &value)
+            {
+                try
+                {
+                    target = value.template get<T>();
+                    return true;
+                }
+                catch (const std::exception &)
+                {
+                    return false;
+                }
+            }
+
+            // Any value of the wrong type invalidates the field, like the type checks in fromJson()
+            template <class T, class Value>
+            static bool assign(T &target, Value &&value)
+            {
+                using V = std::decay_t<Value>;
+                constexpr bool isNumber = std::is_arithmetic_v<V> && !std::is_same_v<V, bool>;
+
+                if constexpr (!isScalar<T>)
+                    return convert(target, json(std::forward<Value>(value)));
+                else if constexpr (std::is_same_v<T, bool>)
+                {
+                    if constexpr (std::is_same_v<V, bool>)
+                        target = value;
+                    return std::is_same_v<V, bool>;
+                }
+                else if constexpr (std::is_integral_v<T>)
+                {
+                    if constexpr (isNumber && std::is_integral_v<V>)
+                        target = static_cast<T>(value);
+                    return isNumber && std::is_integral_v<V>;
+                }
+                else if constexpr (std::is_floating_point_v<T>)
+                {
+                    if constexpr (isNumber)
+                        target = static_cast<T>(value);
+                    return isNumber;
+                }
+                else if constexpr (isInlineString<T>)
+                {
+                    if constexpr (isString<V>)
+                        return target.assign(value);
+                    return false;
+                }
+                else
+                {
+                    if constexpr (isString<V>)
+                        target = std::move(value);
+                    return isString<V>;
+                }
+            }
+
+            template <class Value>
+            bool value(Value &&value)
+            {
+                if (capturing())
+                {
+                    insert(json(std::forward<Value>(value)));
+                }
+                else if (m_atExtra && m_depth == 1)
+                {
+                    m_extra = json(std::forward<Value>(value));
+                }
+                else if (atField())
+                {
+                    visitField<Owner>(m_field, [&](const auto &field)
+                                      { m_valid[m_field] = assign(m_object.*field.member, std::forward<Value>(value)); });
+                }
+                return true;
+            }
+
+            bool startContainer(json container)
+            {
+                if (capturing())
+                {
+                    m_captureStack.push_back(insert(std::move(container)));
+                }
+                else if (atField() && !atScalarField())
+                {
+                    m_capture = std::move(container);
+                    m_captureStack.push_back(&m_capture);
+                }
+                else
+                {
+                    if (m_atExtra && m_depth == 1)
+                        m_extra = std::move(container); // kept as an empty container, only scalars are expected there
+                    invalidate();
+                }
+                m_depth++;
+                return true;
+            }
+
+            bool endContainer()
+            {
+                m_depth--;
+                if (!capturing())
+                    return true;
+
+                m_captureStack.pop_back();
+                if (!capturing())
+                {
+                    visitField<Owner>(m_field, [this](const auto &field)
+                                      {
+                        using T = FieldType<decltype(field)>;
+                        if constexpr (!isScalar<T>)
+                            m_valid[m_field] = convert(m_object.*field.member, m_capture); });
+                    m_capture = json();
+                }
+                return true;
+            }
+
+        public:
+            // extraKey names a top-level value that is not a field, collected for extra() (e.g. a schema version)
+            explicit SaxReader(Owner &object, std::string_view extraKey = {}) : m_object(object), m_extraKey(extraKey) {}
+
+            // the value under extraKey, null if the data had none
+            const json &extra() const { return m_extra; }
+
+            bool null() { return value(nullptr); }
+            bool boolean(bool boolean) { return value(boolean); }
+            bool number_integer(json::number_integer_t number) { return value(number); }
+            bool number_unsigned(json::number_unsigned_t number) { return value(number); }
+            bool number_float(json::number_float_t number, const json::string_t &) { return value(number); }
+            bool string(json::string_t &string) { return value(std::move(string)); }
+            bool binary(json::binary_t &binary) { return value(std::move(binary)); }
+
+            bool start_object(std::size_t) { return startContainer(json::object()); }
+            bool end_object() { return endContainer(); }
+            bool start_array(std::size_t) { return startContainer(json::array()); }
+            bool end_array() { return endContainer(); }
+
+            bool key(json::string_t &name)
+            {
+                if (capturing())
+                    m_captureKey = name;
+                else if (m_depth == 1) // keys at depth 1 can only belong to the top-level object
+                {
+                    m_atExtra = !m_extraKey.empty() && name == m_extraKey;
+                    m_field = m_atExtra ? NONE : findField<Owner>(name);
+                }
+                return true;
+            }
+
+            // Rethrows the parser's own exception type, so callers see the same errors as json::parse()
+            template <class Exception>
+            bool parse_error(std::size_t, const std::string &, const Exception &e)
+            {
+                throw e;
+            }
+
+            // throws std::runtime_error naming the first field that was missing or invalid
+            void checkComplete() const
+            {
+                std::size_t index = 0;
+                forEachField<Owner>([&](const auto &field)
+                                    {
+                    if (!m_valid[index++])
+                        throw invalidField(field.key); });
+            }
+        };
+
+        // Streams data into a new Owner without building a json DOM, throws like fromJson() and json::exception for malformed data
+        template <class Owner>
+        Owner parse(std::string_view data, json::input_format_t format)
+        {
+            Owner object;
+            SaxReader<Owner> reader(object);
+            json::sax_parse(data.data(), data.data() + data.size(), &reader, format);
+            reader.checkComplete();
+            return object;
+        }
+    } // namespace reflection
+} // namespace datacoe
\ No newline at end of file
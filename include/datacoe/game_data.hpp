@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <nlohmann/json.hpp>
+#include "field_reflection.hpp"
 
 using json = nlohmann::json;
 
@@ -15,16 +20,68 @@ namespace datacoe
         int m_highscore;
 
     public:
-        GameData(const std::string &nickname = "", const int highscore = 0);
+        // Strings are taken by value and moved in, pass std::move() or a temporary to avoid the copy
+        GameData(std::string nickname = "", const int highscore = 0);
 
-        void setNickname(const std::string &nickname);
+        void setNickname(std::string nickname);
         void setHighscore(int highscore);
 
         const std::string &getNickname() const;
         int getHighscore() const;
 
-        json toJson() const;
+        // Version of the field list below, written into every save under SCHEMA_VERSION_KEY
+        // Bump it whenever fields are added, removed, renamed or change type, and add the step from the old version
+        // to schema_migrations.cpp, so older saves keep loading
+        static constexpr int SCHEMA_VERSION = 1;
+        static constexpr const char *SCHEMA_VERSION_KEY = "schemaVersion";
 
+        // Every field of GameData, the one list the methods below are generated from (see field_reflection.hpp)
+        // Users add their own fields here, a key is the field's name in save files
+        static constexpr auto fields()
+        {
+            return std::make_tuple(field("nickname", &GameData::m_nickname),
+                                   field("highscore", &GameData::m_highscore));
+        }
+
+        // The fields a save menu shows, a subset of fields() that saves store again in a small block at the front of the file,
+        // so DataReaderWriter::readSummary() can read them without decoding the rest. Keep it to a few small fields
+        static constexpr auto summaryFields()
+        {
+            return std::make_tuple(field("nickname", &GameData::m_nickname),
+                                   field("highscore", &GameData::m_highscore));
+        }
+
+        // Compares every field, DataManager uses it to skip saving unchanged data
+        bool operator==(const GameData &other) const;
+        bool operator!=(const GameData &other) const;
+
+        // JSON Patch (RFC 6902) from `from` to this GameData, replacing only the fields that differ
+        json diff(const GameData &from) const;
+
+        std::size_t hash() const;
+
+        // The fields and the SCHEMA_VERSION
+        // chunks (optional) stores the chunks of ChunkedVector fields and writes their manifests, DataReaderWriter passes it
+        json toJson(ChunkWriter *chunks = nullptr) const;
+
+        // Older schema versions are migrated first (see schema_migrations.hpp), newer ones are rejected
         static GameData fromJson(const json &j);
+        // Moves the strings out of j instead of copying them
+        static GameData fromJson(json &&j);
+
+        // Streaming alternative to fromJson(), fills the fields as the parser reports them without building a json DOM
+        // Does the same validation as fromJson(), throws json::exception for malformed data
+        // Only saves of an older schema version are decoded into json to be migrated, schemaVersion (optional)
+        // receives the version the data was stored with
+        static GameData parse(std::string_view data, json::input_format_t format = json::input_format_t::json, int *schemaVersion = nullptr);
+    };
+} // namespace datacoe
+
+namespace std
+{
+    template <>
+    struct hash<datacoe::GameData>
+    {
+        std::size_t operator()(const datacoe::GameData &gamedata) const { return gamedata.hash(); }
     };
-} // namespace datacoe
\ No newline at end of file
+} // namespace std
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace datacoe
+{
+    // A string of at most Capacity bytes stored inside the object, for short GameData fields like nicknames or titles
+    // It never allocates and is trivially copyable, so a struct of such fields copies with a memcpy and arrays of them
+    // are contiguous. Capacity counts bytes, not characters, a UTF-8 nickname of N characters may need up to 4 * N.
+    // Overflow policy: text longer than Capacity is an error, never silently cut:
+    //   - the constructors throw std::length_error, like std::string past max_size()
+    //   - assign() returns false and leaves the string unchanged
+    //   - loading a save whose value does not fit fails on that field, like a value of the wrong type
+    //   - truncated() is the explicit way to keep the longest prefix that fits
+    template <std::size_t Capacity>
+    class InlineString
+    {
+        static_assert(Capacity > 0 && Capacity <= 0xFFFF, "InlineString holds 1 to 65535 bytes");
+
+    public:
+        using size_type = std::conditional_t<(Capacity <= 0xFF), std::uint8_t, std::uint16_t>;
+
+    private:
+        char m_data[Capacity + 1] = {}; // always NUL-terminated
+        size_type m_size = 0;
+
+        void set(std::string_view text)
+        {
+            std::memcpy(m_data, text.data(), text.size());
+            m_data[text.size()] = '\0';
+            m_size = static_cast<size_type>(text.size());
+        }
+
+    public:
+        InlineString() = default;
+
+        InlineString(std::string_view text)
+        {
+            if (!assign(text))
+                throw std::length_error("InlineString holds " + std::to_string(Capacity) + " bytes, the text has " + std::to_string(text.size()));
+        }
+
+        InlineString(const char *text) : InlineString(std::string_view(text)) {}
+        InlineString(const std::string &text) : InlineString(std::string_view(text)) {}
+
+        static constexpr std::size_t capacity() { return Capacity; }
+        static constexpr bool fits(std::string_view text) { return text.size() <= Capacity; }
+
+        // The longest prefix of text that fits, cut before a UTF-8 sequence that would be split
+        static InlineString truncated(std::string_view text)
+        {
+            if (text.size() > Capacity)
+            {
+                std::size_t length = Capacity;
+                while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80)
+                    length--;
+                text = text.substr(0, length);
+            }
+            InlineString result;
+            result.set(text);
+            return result;
+        }
+
+        // false if text does not fit, the string keeps its value then
+        bool assign(std::string_view text)
+        {
+            if (!fits(text))
+                return false;
+            set(text);
+            return true;
+        }
+
+        void clear() { set(std::string_view()); }
+
+        std::size_t size() const { return m_size; }
+        std::size_t length() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        const char *data() const { return m_data; }
+        const char *c_str() const { return m_data; }
+        char operator[](std::size_t index) const { return m_data[index]; }
+
+        std::string_view view() const { return std::string_view(m_data, m_size); }
+        operator std::string_view() const { return view(); }
+        std::string str() const { return std::string(m_data, m_size); }
+
+        friend bool operator==(const InlineString &a, const InlineString &b) { return a.view() == b.view(); }
+        friend bool operator!=(const InlineString &a, const InlineString &b) { return a.view() != b.view(); }
+        friend bool operator<(const InlineString &a, const InlineString &b) { return a.view() < b.view(); }
+
+        // Comparisons with std::string, std::string_view and string literals, without converting them first
+        template <class Text, class = std::enable_if_t<std::is_convertible_v<const Text &, std::string_view> &&
+                                                       !std::is_same_v<Text, InlineString>>>
+        friend bool operator==(const InlineString &a, const Text &b) { return a.view() == std::string_view(b); }
+        template <class Text, class = std::enable_if_t<std::is_convertible_v<const Text &, std::string_view> &&
+                                                       !std::is_same_v<Text, InlineString>>>
+        friend bool operator==(const Text &a, const InlineString &b) { return std::string_view(a) == b.view(); }
+        template <class Text, class = std::enable_if_t<std::is_convertible_v<const Text &, std::string_view> &&
+                                                       !std::is_same_v<Text, InlineString>>>
+        friend bool operator!=(const InlineString &a, const Text &b) { return !(a == b); }
+        template <class Text, class = std::enable_if_t<std::is_convertible_v<const Text &, std::string_view> &&
+                                                       !std::is_same_v<Text, InlineString>>>
+        friend bool operator!=(const Text &a, const InlineString &b) { return !(a == b); }
+    };
+
+    template <std::size_t Capacity>
+    void to_json(json &j, const InlineString<Capacity> &text)
+    {
+        j = text.view();
+    }
+
+    // throws json::type_error for a value that is not a string and std::length_error for one that does not fit
+    template <std::size_t Capacity>
+    void from_json(const json &j, InlineString<Capacity> &text)
+    {
+        text = InlineString<Capacity>(j.get_ref<const std::string &>());
+    }
+} // namespace datacoe
+
+namespace std
+{
+    template <std::size_t Capacity>
+    struct hash<datacoe::InlineString<Capacity>>
+    {
+        std::size_t operator()(const datacoe::InlineString<Capacity> &text) const { return std::hash<std::string_view>{}(text.view()); }
+    };
+} // namespace std
\ No newline at end of file
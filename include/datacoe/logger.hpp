@@ -0,0 +1,70 @@
+#pragma once
+
+#include <functional>
+#include <sstream>
+#include <string>
+
+// Compile-time minimum log level (0 = Trace, 1 = Debug, 2 = Info, 3 = Warning, 4 = Error, 5 = Off)
+// Messages below this level are removed by the compiler, including the formatting of their arguments
+// Can be set through the DATACOE_LOG_MIN_LEVEL CMake cache variable
+#ifndef DATACOE_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define DATACOE_LOG_MIN_LEVEL 2
+#else
+#define DATACOE_LOG_MIN_LEVEL 1
+#endif
+#endif
+
+namespace datacoe
+{
+    enum class LogLevel
+    {
+        Trace = 0,
+        Debug = 1,
+        Info = 2,
+        Warning = 3,
+        Error = 4,
+        Off = 5
+    };
+
+    // No need to modify, use setSink() to redirect the output into your engine's logger
+    class Logger
+    {
+    public:
+        using Sink = std::function<void(LogLevel level, const std::string &message)>;
+
+        static constexpr LogLevel COMPILE_TIME_MIN_LEVEL = static_cast<LogLevel>(DATACOE_LOG_MIN_LEVEL);
+
+        // Replaces the output sink, passing an empty sink restores the default stdio sink
+        // The sink may be called from any thread that uses datacoe, calls are serialized
+        static void setSink(Sink sink);
+
+        // Runtime filter, applied on top of the compile-time minimum level
+        static void setLevel(LogLevel level);
+        static LogLevel getLevel();
+        static bool isEnabled(LogLevel level);
+
+        static void write(LogLevel level, const std::string &message);
+        static const char *levelName(LogLevel level);
+    };
+} // namespace datacoe
+
+#define DATACOE_LOG(level, expr)                                                   \
+    do                                                                             \
+    {                                                                              \
+        if constexpr (static_cast<int>(level) >= DATACOE_LOG_MIN_LEVEL)            \
+        {                                                                          \
+            if (::datacoe::Logger::isEnabled(level))                               \
+            {                                                                      \
+                std::ostringstream datacoeLogStream;                               \
+                datacoeLogStream << expr;                                          \
+                ::datacoe::Logger::write(level, datacoeLogStream.str());           \
+            }                                                                      \
+        }                                                                          \
+    } while (0)
+
+#define DATACOE_LOG_TRACE(expr) DATACOE_LOG(::datacoe::LogLevel::Trace, expr)
+#define DATACOE_LOG_DEBUG(expr) DATACOE_LOG(::datacoe::LogLevel::Debug, expr)
+#define DATACOE_LOG_INFO(expr) DATACOE_LOG(::datacoe::LogLevel::Info, expr)
+#define DATACOE_LOG_WARNING(expr) DATACOE_LOG(::datacoe::LogLevel::Warning, expr)
+#define DATACOE_LOG_ERROR(expr) DATACOE_LOG(::datacoe::LogLevel::Error, expr)
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+#include "data_reader_writer.hpp"
+#include "game_data.hpp"
+
+namespace datacoe
+{
+    // What a save menu shows for a slot, kept in the slot index so listing never opens the slot files
+    struct SlotInfo
+    {
+        std::string name;           // slot name, the save file is <name>.sav in the slots directory
+        std::string nickname;
+        int highscore = 0;
+        std::int64_t timestamp = 0; // last save, seconds since the Unix epoch
+        std::uint64_t size = 0;     // save file size in bytes
+        std::uint32_t checksum = 0; // CRC-32 of the save file
+    };
+
+    // Save slots in one directory, next to a small index file with the SlotInfo of every slot, encrypted like the slots.
+    // save() writes the slot and then the index, both atomically, while a marker file names the slot
+    // in between, so after a crash open() knows which index entry to refresh from its slot file
+    class SaveSlots
+    {
+        std::string m_directory;
+        WriteOptions m_options;
+        std::map<std::string, SlotInfo> m_slots;
+
+        std::string pathOf(const std::string &file) const;
+        std::string slotPath(const std::string &name) const;
+        // sealed receives whether the index was stored encrypted
+        bool loadIndex(bool &sealed);
+        bool writeIndex();
+        bool writePendingMarker(const std::string &name);
+        void removePendingMarker();
+        // rebuilds the SlotInfo of one slot from its file, dropping it from the index if the file is gone
+        bool refreshSlot(const std::string &name);
+
+    public:
+        static constexpr const char *INDEX_FILENAME = "slots.index";
+        static constexpr const char *PENDING_FILENAME = "slots.index.pending";
+        static constexpr const char *SLOT_EXTENSION = ".sav";
+
+        // opens the slots directory, creating it if needed, options are used by every save()
+        // a missing or unreadable index is rebuilt from the slot files
+        bool open(const std::string &directory, const WriteOptions &options = WriteOptions());
+
+        bool save(const std::string &name, const GameData &gamedata);
+        std::optional<GameData> load(const std::string &name) const;
+        bool remove(const std::string &name);
+
+        // served from the index only, sorted by slot name
+        std::vector<SlotInfo> list() const;
+        std::optional<SlotInfo> info(const std::string &name) const;
+        std::size_t size() const;
+
+        // reads every slot file and rewrites the index
+        bool rebuildIndex();
+
+        // letters, digits, '-' and '_' only, so a slot name is always a plain file name
+        static bool isValidName(const std::string &name);
+    };
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <nlohmann/json.hpp>
+#include "game_data.hpp"
+
+using json = nlohmann::json;
+
+namespace datacoe
+{
+    // Upgrades a decoded save from one schema version to the next, working on its json form
+    // A step that throws makes the save unreadable
+    using MigrationStep = std::function<void(json &save)>;
+
+    // The steps between GameData schema versions. GameData::fromJson() and GameData::parse(), so readData() and loadGame()
+    // too, run them only for saves older than GameData::SCHEMA_VERSION, up-to-date saves never reach this class.
+    // Saves written before schema versions existed have no version key and count as version 0
+    class SchemaMigrations
+    {
+    public:
+        // Registers the step that upgrades fromVersion to fromVersion + 1, replacing an earlier one
+        // The steps that ship with the game are listed in schema_migrations.cpp, this is for steps added at runtime
+        static void add(int fromVersion, MigrationStep step);
+
+        // Drops the steps registered with add(), the ones in schema_migrations.cpp stay
+        static void reset();
+
+        // Runs the steps from version up to targetVersion on save and stores targetVersion in it
+        // throws std::runtime_error if a step is missing, or whatever a step throws
+        static void migrate(json &save, int version, int targetVersion = GameData::SCHEMA_VERSION);
+    };
+} // namespace datacoe
\ No newline at end of file
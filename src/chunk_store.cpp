@@ -0,0 +1,396 @@
+#include "chunk_store.hpp"
+#include "datacoe/logger.hpp"
+#include "crypto.hpp"
+#include "file_writer.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <system_error>
+
+namespace datacoe
+{
+    namespace
+    {
+        constexpr char MAGIC[4] = {'D', 'C', 'O', 'P'};
+        constexpr std::uint8_t FLAG_ENCRYPTED = 0x80;
+
+        void appendUint(std::string &out, std::uint64_t value, std::size_t bytes)
+        {
+            for (std::size_t i = 0; i < bytes; i++)
+                out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+
+        std::uint64_t readUint(std::string_view data, std::size_t offset, std::size_t bytes)
+        {
+            std::uint64_t value = 0;
+            for (std::size_t i = 0; i < bytes; i++)
+                value |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(data[offset + i])) << (8 * i);
+            return value;
+        }
+
+        // The lock of one save file, shared by the saves and loads of it in progress and dropped once they are done
+        // Keyed by the absolute path, so different spellings of the same file share it
+        std::shared_ptr<std::mutex> saveMutex(const std::string &saveFilename)
+        {
+            static std::mutex registryMutex;
+            static std::map<std::string, std::weak_ptr<std::mutex>> registry;
+
+            std::error_code ec;
+            std::filesystem::path absolute = std::filesystem::absolute(saveFilename, ec);
+            std::string key = ec ? saveFilename : absolute.lexically_normal().string();
+
+            std::lock_guard<std::mutex> lock(registryMutex);
+            for (auto it = registry.begin(); it != registry.end();)
+                it = it->second.expired() ? registry.erase(it) : std::next(it);
+
+            std::weak_ptr<std::mutex> &entry = registry[key];
+            std::shared_ptr<std::mutex> mutex = entry.lock();
+            if (!mutex)
+            {
+                mutex = std::make_shared<std::mutex>();
+                entry = mutex;
+            }
+            return mutex;
+        }
+
+        // opens a pack file and reads the generation and id from its header
+        bool openPack(const std::string &path, std::ifstream &file, std::uint64_t &generation, std::uint64_t &id, std::string &error)
+        {
+            file.open(path, std::ios::binary);
+            if (!file)
+            {
+                error = "Could not open chunk pack: " + path;
+                return false;
+            }
+
+            char header[ChunkPack::HEADER_SIZE];
+            if (!file.read(header, ChunkPack::HEADER_SIZE))
+            {
+                error = "Truncated chunk pack header: " + path;
+                return false;
+            }
+            std::string_view view(header, ChunkPack::HEADER_SIZE);
+            if (view.substr(0, sizeof(MAGIC)) != std::string_view(MAGIC, sizeof(MAGIC)) || static_cast<std::uint8_t>(header[4]) != ChunkPack::CURRENT_VERSION)
+            {
+                error = "Not a chunk pack: " + path;
+                return false;
+            }
+            generation = readUint(view, 8, 8);
+            id = readUint(view, 16, 8);
+            return true;
+        }
+
+        // a pack that is already gone is fine, one that can't be deleted is left for the next save (see ChunkStore)
+        void removePack(const char *caller, const std::string &path)
+        {
+            std::error_code ec;
+            if (!std::filesystem::remove(path, ec) && ec)
+                DATACOE_LOG_WARNING(caller << " Could not delete chunk pack: " << path << " (" << ec.message() << ")");
+        }
+
+        std::uint64_t randomId()
+        {
+            CryptoPP::byte bytes[8];
+            cryptoContext().rng.GenerateBlock(bytes, sizeof(bytes));
+            return readUint(std::string_view(reinterpret_cast<const char *>(bytes), sizeof(bytes)), 0, sizeof(bytes));
+        }
+    } // namespace
+
+    std::string ChunkPack::makeHeader(std::uint64_t generation, std::uint64_t id)
+    {
+        std::string header(MAGIC, sizeof(MAGIC));
+        header.push_back(static_cast<char>(CURRENT_VERSION));
+        appendUint(header, 0, 3);
+        appendUint(header, generation, 8);
+        appendUint(header, id, 8);
+        return header;
+    }
+
+    std::shared_ptr<const ChunkPack> ChunkPack::open(const std::string &path, std::uint64_t generation, std::string &error)
+    {
+        auto pack = std::make_shared<ChunkPack>();
+        pack->m_path = path;
+        std::ifstream file;
+        if (!openPack(path, file, pack->m_generation, pack->m_id, error))
+            return nullptr;
+        if (generation != 0 && pack->m_generation != generation)
+        {
+            error = "Chunk pack " + path + " holds generation " + std::to_string(pack->m_generation) + " instead of " + std::to_string(generation);
+            return nullptr;
+        }
+        return pack;
+    }
+
+    bool ChunkPack::read(std::uint64_t offset, std::uint64_t length, std::string &out, std::string &error) const
+    {
+        std::ifstream file;
+        std::uint64_t generation = 0;
+        std::uint64_t id = 0;
+        if (!openPack(m_path, file, generation, id, error))
+            return false;
+        if (generation != m_generation || id != m_id)
+        {
+            error = "Chunk pack " + m_path + " was replaced by generation " + std::to_string(generation);
+            return false;
+        }
+        file.seekg(0, std::ios::end);
+        std::uint64_t size = static_cast<std::uint64_t>(file.tellg());
+        if (offset < HEADER_SIZE || offset > size || length > size - offset)
+        {
+            error = "Chunk at offset " + std::to_string(offset) + " is past the end of " + m_path;
+            return false;
+        }
+
+        out.resize(static_cast<std::size_t>(length));
+        file.seekg(static_cast<std::streamoff>(offset));
+        if (!file.read(out.data(), static_cast<std::streamsize>(length)))
+        {
+            error = "Could not read chunk at offset " + std::to_string(offset) + " of " + m_path;
+            return false;
+        }
+        return true;
+    }
+
+    std::string ChunkStore::pathFor(const std::string &saveFilename, std::uint64_t generation)
+    {
+        return saveFilename + EXTENSION + std::to_string(generation % 2);
+    }
+
+    void ChunkStore::remove(const std::string &saveFilename)
+    {
+        std::shared_ptr<std::mutex> mutex = saveMutex(saveFilename);
+        std::lock_guard<std::mutex> lock(*mutex);
+        removePack("ChunkStore::remove()", pathFor(saveFilename, 0));
+        removePack("ChunkStore::remove()", pathFor(saveFilename, 1));
+    }
+
+    std::uint8_t ChunkStore::flagsOf(const WriteOptions &options)
+    {
+        std::uint8_t flags = static_cast<std::uint8_t>(static_cast<std::uint8_t>(options.format) | (static_cast<std::uint8_t>(options.compression) << 4));
+        if (options.encryption)
+            flags |= FLAG_ENCRYPTED;
+        return flags;
+    }
+
+    bool ChunkStore::attachFields(const std::vector<ChunkedField *> &fields, const std::string &saveFilename, std::string &error)
+    {
+        // a save of the same file must not delete a pack between here and the open
+        std::shared_ptr<std::mutex> mutex = saveMutex(saveFilename);
+        std::lock_guard<std::mutex> lock(*mutex);
+
+        std::map<std::uint64_t, std::shared_ptr<const ChunkPack>> packs;
+        auto openPack = [&](std::uint64_t generation)
+        {
+            auto it = packs.find(generation);
+            if (it == packs.end())
+                it = packs.emplace(generation, ChunkPack::open(pathFor(saveFilename, generation), generation, error)).first;
+            return it->second;
+        };
+
+        bool attached = true;
+        for (ChunkedField *field : fields)
+            attached = field->attach(openPack) && attached;
+        return attached;
+    }
+
+    json ChunkStore::load(const ChunkLocation &location)
+    {
+        if (!location.pack)
+            throw std::runtime_error("ChunkedVector chunk is not attached to a chunk pack, load the save with DataReaderWriter::readData() or DataManager");
+
+        std::string blob;
+        std::string error;
+        if (!location.pack->read(location.offset, location.length, blob, error))
+        {
+            DATACOE_LOG_ERROR("ChunkStore::load() " << error);
+            throw std::runtime_error(error);
+        }
+        if (crc32(blob) != location.checksum)
+        {
+            error = "Chunk at offset " + std::to_string(location.offset) + " of " + location.pack->path() + " is corrupted";
+            DATACOE_LOG_ERROR("ChunkStore::load() " << error);
+            throw std::runtime_error(error);
+        }
+
+        std::optional<json> document = DataReaderWriter::decodeDocument(blob, (location.flags & FLAG_ENCRYPTED) != 0);
+        if (!document || !document->is_object() || !document->contains("elements") || !(*document)["elements"].is_array())
+        {
+            error = "Chunk at offset " + std::to_string(location.offset) + " of " + location.pack->path() + " is unreadable";
+            DATACOE_LOG_ERROR("ChunkStore::load() " << error);
+            throw std::runtime_error(error);
+        }
+        return std::move((*document)["elements"]);
+    }
+
+    ChunkStore::ChunkStore(std::string saveFilename, const WriteOptions &options)
+        : m_filename(std::move(saveFilename)), m_options(options), m_flags(flagsOf(options)), m_saveMutex(saveMutex(m_filename)), m_lock(*m_saveMutex) {}
+
+    bool ChunkStore::reusable(const ChunkLocation &location) const
+    {
+        return m_pack && location.pack && location.pack->id() == m_pack->id() && location.generation == m_pack->generation() &&
+               location.flags == m_flags;
+    }
+
+    void ChunkStore::planFields(const std::vector<const ChunkedField *> &fields)
+    {
+        bool hasChunks = std::any_of(fields.begin(), fields.end(), [](const ChunkedField *field)
+                                     { return field->chunkCount() > 0; });
+        if (!hasChunks)
+            return; // nothing to store, finish() deletes the packs
+
+        std::uint64_t latest = 0;
+        std::size_t packs = 0;
+        for (std::uint64_t parity = 0; parity < 2; parity++)
+        {
+            std::string error;
+            std::shared_ptr<const ChunkPack> pack = ChunkPack::open(pathFor(m_filename, parity), 0, error);
+            if (!pack || pack->generation() % 2 != parity)
+                continue;
+            packs++;
+            if (pack->generation() > latest)
+            {
+                latest = pack->generation();
+                m_pack = std::move(pack);
+            }
+        }
+
+        if (m_pack)
+        {
+            std::error_code ec;
+            m_packSize = std::filesystem::file_size(m_pack->path(), ec);
+
+            std::uint64_t live = 0;
+            for (const ChunkedField *field : fields)
+            {
+                for (const std::shared_ptr<ChunkBase> &chunk : field->chunks())
+                {
+                    ChunkLocation location = chunk->location();
+                    if (reusable(location))
+                        live += location.length;
+                }
+            }
+
+            // While both packs exist the save file may still reference the older one (a save was interrupted after
+            // writing a new generation), which the next generation would overwrite, so the newer one is appended to
+            // until a finished save has deleted the older one
+            std::uint64_t garbage = ec || m_packSize < ChunkPack::HEADER_SIZE + live ? 0 : m_packSize - ChunkPack::HEADER_SIZE - live;
+            if (!ec && (packs == 2 || garbage <= std::max(live, MIN_GARBAGE)))
+            {
+                m_generation = latest;
+                return;
+            }
+            DATACOE_LOG_DEBUG("ChunkStore::plan() Rewriting the chunk pack of " << m_filename << ", " << garbage << " of its bytes are garbage");
+            m_pack.reset();
+        }
+
+        m_generation = latest + 1;
+        m_packSize = ChunkPack::HEADER_SIZE;
+    }
+
+    ChunkLocation ChunkStore::store(const std::shared_ptr<ChunkBase> &chunk)
+    {
+        if (!m_error.empty())
+            return ChunkLocation();
+        if (m_generation == 0)
+        {
+            m_error = "No chunk pack was planned for " + m_filename;
+            return ChunkLocation();
+        }
+
+        ChunkLocation current = chunk->location();
+        if (reusable(current))
+            return current;
+
+        try
+        {
+            // a chunk stored by another save with the same options is copied as it is, anything else is encoded
+            std::string blob;
+            std::string error;
+            if (current.stored() && current.pack && current.flags == m_flags &&
+                (!current.pack->read(current.offset, current.length, blob, error) || crc32(blob) != current.checksum))
+                blob.clear();
+
+            if (blob.empty())
+            {
+                json document = {{"elements", chunk->elements()}};
+                std::optional<std::string> encoded = DataReaderWriter::encodeDocument(document, m_options);
+                if (!encoded)
+                {
+                    m_error = "Could not encode a chunk";
+                    return ChunkLocation();
+                }
+                blob = std::move(*encoded);
+            }
+
+            ChunkLocation placed;
+            placed.generation = m_generation;
+            placed.offset = m_packSize + m_pending.size();
+            placed.length = blob.size();
+            placed.checksum = crc32(blob);
+            placed.flags = m_flags;
+            m_pending.append(blob);
+            m_placed.emplace_back(chunk, placed);
+            return placed;
+        }
+        catch (const std::exception &e)
+        {
+            m_error = e.what();
+            return ChunkLocation();
+        }
+    }
+
+    bool ChunkStore::flush(std::string &error)
+    {
+        if (!m_error.empty())
+        {
+            error = "Could not store the chunks of " + m_filename + ": " + m_error;
+            return false;
+        }
+        if (m_placed.empty())
+            return true;
+
+        std::string path = pathFor(m_filename, m_generation);
+        if (!m_pack)
+        {
+            // a new generation is written whole, into the file of the previous generation but one, which nothing references
+            std::string data = ChunkPack::makeHeader(m_generation, randomId());
+            data.append(m_pending);
+            if (!FileWriter::writeAtomically(path, data, m_options.durability, error))
+                return false;
+            m_pack = ChunkPack::open(path, m_generation, error);
+            if (!m_pack)
+                return false;
+        }
+        else if (!FileWriter::append(path, m_pending, m_options.durability, error))
+        {
+            return false;
+        }
+        DATACOE_LOG_DEBUG("ChunkStore::flush() Wrote " << m_placed.size() << " chunks (" << m_pending.size() << " bytes) to " << path);
+
+        for (auto &[chunk, location] : m_placed)
+        {
+            location.pack = m_pack;
+            chunk->setLocation(std::move(location));
+        }
+        m_packSize += m_pending.size();
+        m_pending.clear();
+        m_placed.clear();
+        return true;
+    }
+
+    void ChunkStore::finish()
+    {
+        if (!m_chunked)
+            return; // a type without ChunkedVector fields never has packs
+        if (m_generation == 0)
+        {
+            removePack("ChunkStore::finish()", pathFor(m_filename, 0));
+            removePack("ChunkStore::finish()", pathFor(m_filename, 1));
+            return;
+        }
+        // the other file holds the previous generation, or nothing
+        removePack("ChunkStore::finish()", pathFor(m_filename, m_generation + 1));
+    }
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "datacoe/chunked_vector.hpp"
+#include "datacoe/data_reader_writer.hpp"
+#include "datacoe/field_reflection.hpp"
+
+namespace datacoe
+{
+    // Internal helper, not part of the public API
+    // One chunk pack of a save, opened for reading chunks on demand
+    // All integers little-endian:
+    //   header: magic "DCOP" (4) | version (1) | reserved (3) | generation (8) | pack id (8)
+    //   then the chunk blobs back to back, each one the bytes DataReaderWriter writes for {"elements": [...]}
+    // Blobs have no framing, the save's manifests list their offset, length and CRC-32.
+    // The pack id is random, it tells a pack apart from an older one that had the same name
+    // The file is only open during a read, so a later save can always replace or delete it (Windows can't delete an
+    // open file). A chunk that was not loaded before its generation was deleted can't be read anymore
+    class ChunkPack
+    {
+        std::string m_path;
+        std::uint64_t m_generation = 0;
+        std::uint64_t m_id = 0;
+
+    public:
+        static constexpr std::size_t HEADER_SIZE = 24;
+        static constexpr std::uint8_t CURRENT_VERSION = 1;
+
+        static std::string makeHeader(std::uint64_t generation, std::uint64_t id);
+
+        // Checks the header of the pack, returns null and fills error if it can't be read
+        // or holds another generation (0 accepts any)
+        static std::shared_ptr<const ChunkPack> open(const std::string &path, std::uint64_t generation, std::string &error);
+
+        // reads length bytes at offset into out, fails if the file no longer holds this pack
+        bool read(std::uint64_t offset, std::uint64_t length, std::string &out, std::string &error) const;
+
+        const std::string &path() const { return m_path; }
+        std::uint64_t generation() const { return m_generation; }
+        std::uint64_t id() const { return m_id; }
+    };
+
+    // Internal helper, not part of the public API
+    // The save side of ChunkedVector fields: writes the chunks of one save of a GameData (or any type with fields())
+    // into the save's chunk pack. Types without ChunkedVector fields never touch the packs
+    // A save has two pack files next to it, <save>.chunks0 and <save>.chunks1, holding even and odd generations.
+    // Packs are append-only, a save appends the chunks that are not in its pack yet and unchanged chunks keep their blob.
+    // Once most of the pack is garbage the save writes the live chunks into the next generation, the other file, and
+    // finish() deletes the old one after the save file that references the new generation is in place, so a crash
+    // leaves the old save with its old pack. An old pack that can't be deleted stays until a later save manages to,
+    // saves append to the newer pack meanwhile. Saves of the same file are serialized, from the constructor until the
+    // ChunkStore is destroyed
+    class ChunkStore : public ChunkWriter
+    {
+        std::string m_filename;
+        WriteOptions m_options;
+        std::uint8_t m_flags;
+        std::shared_ptr<std::mutex> m_saveMutex; // of this save file, see the constructor
+        std::unique_lock<std::mutex> m_lock;
+        bool m_chunked = false; // the planned type has ChunkedVector fields
+
+        std::uint64_t m_generation = 0;          // of the pack this save writes to, 0 if there are no chunks
+        std::shared_ptr<const ChunkPack> m_pack; // that pack, null until it exists
+        std::uint64_t m_packSize = 0;
+        std::string m_pending; // blobs for the end of the pack
+        std::vector<std::pair<std::shared_ptr<ChunkBase>, ChunkLocation>> m_placed;
+        std::string m_error;
+
+        bool reusable(const ChunkLocation &location) const;
+        void planFields(const std::vector<const ChunkedField *> &fields);
+        static bool attachFields(const std::vector<ChunkedField *> &fields, const std::string &saveFilename, std::string &error);
+
+    public:
+        static constexpr const char *EXTENSION = ".chunks";
+        // the pack is rewritten once it holds more garbage than live chunks, and at least this much of it
+        static constexpr std::uint64_t MIN_GARBAGE = 64 * 1024;
+
+        static std::string pathFor(const std::string &saveFilename, std::uint64_t generation);
+        // deletes both packs of saveFilename
+        static void remove(const std::string &saveFilename);
+
+        // Attaches the chunks of an object read from saveFilename to its packs, returns false and fills error if one is missing
+        template <class Owner>
+        static bool attach(Owner &object, const std::string &saveFilename, std::string &error)
+        {
+            if constexpr (!reflection::hasChunkedFields<Owner>)
+                return true;
+            std::vector<ChunkedField *> fields;
+            reflection::forEachChunkedField(object, [&fields](ChunkedField &field)
+                                            { fields.push_back(&field); });
+            return attachFields(fields, saveFilename, error);
+        }
+
+        // the flags byte of chunk locations written with options
+        static std::uint8_t flagsOf(const WriteOptions &options);
+
+        // Reads the elements of a stored chunk, throws std::runtime_error if it can't
+        static json load(const ChunkLocation &location);
+
+        ChunkStore(std::string saveFilename, const WriteOptions &options);
+
+        // Picks the pack the chunks of object go to, call before encoding it
+        template <class Owner>
+        void plan(const Owner &object)
+        {
+            m_chunked = reflection::hasChunkedFields<Owner>;
+            if constexpr (!reflection::hasChunkedFields<Owner>)
+                return;
+            std::vector<const ChunkedField *> fields;
+            reflection::forEachChunkedField(object, [&fields](const ChunkedField &field)
+                                            { fields.push_back(&field); });
+            planFields(fields);
+        }
+
+        ChunkLocation store(const std::shared_ptr<ChunkBase> &chunk) override;
+        bool flush(std::string &error) override;
+
+        // Call once the save file is in place, deletes the pack it no longer references
+        void finish();
+    };
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "datacoe/chunked_vector.hpp"
+#include "chunk_store.hpp"
+#include "crypto.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace datacoe
+{
+    bool ChunkLocation::sameBlob(const ChunkLocation &other) const
+    {
+        // the checksum covers the random IV of encrypted blobs, equal blobs at the same place are the same blob
+        return stored() && generation == other.generation && offset == other.offset && length == other.length &&
+               checksum == other.checksum && flags == other.flags;
+    }
+
+    json ChunkBase::loadLocked() const
+    {
+        return ChunkStore::load(m_location);
+    }
+
+    ChunkLocation ChunkBase::location() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_location;
+    }
+
+    void ChunkBase::setLocation(ChunkLocation location)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_location = std::move(location);
+    }
+
+    void ChunkBase::markChanged()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_location = ChunkLocation();
+        m_hasDigest = false;
+    }
+
+    std::uint32_t ChunkBase::digest() const
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_hasDigest)
+                return m_digest;
+        }
+
+        // elements() takes the lock itself to load a stored chunk
+        std::uint32_t digest = crc32(elements().dump());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_digest = digest;
+        m_hasDigest = true;
+        return digest;
+    }
+
+    std::vector<ChunkedField::StoredChunk> ChunkedField::parseManifest(const json &manifest, std::size_t chunkSize, std::size_t &size)
+    {
+        if (!manifest.is_object())
+            throw std::invalid_argument("A ChunkedVector field is neither an array nor a chunk manifest");
+
+        std::uint64_t generation = manifest.at("pack").get<std::uint64_t>();
+        size = manifest.at("size").get<std::size_t>();
+        const json &entries = manifest.at("chunks");
+        if (!entries.is_array())
+            throw std::invalid_argument("A ChunkedVector manifest has no list of chunks");
+
+        std::vector<StoredChunk> chunks;
+        chunks.reserve(entries.size());
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < entries.size(); i++)
+        {
+            const json &entry = entries[i];
+            if (!entry.is_array() || entry.size() != 6)
+                throw std::invalid_argument("A ChunkedVector manifest has a malformed chunk entry");
+
+            StoredChunk chunk;
+            chunk.location.generation = generation;
+            chunk.location.offset = entry[0].get<std::uint64_t>();
+            chunk.location.length = entry[1].get<std::uint64_t>();
+            chunk.location.checksum = entry[2].get<std::uint32_t>();
+            chunk.count = entry[3].get<std::size_t>();
+            chunk.location.flags = entry[4].get<std::uint8_t>();
+            chunk.digest = entry[5].get<std::uint32_t>();
+
+            // every chunk but the last is full, element i is always in chunk i / chunkSize
+            bool last = i + 1 == entries.size();
+            if (chunk.count == 0 || chunk.count > chunkSize || (!last && chunk.count != chunkSize))
+                throw std::invalid_argument("A ChunkedVector manifest has a chunk of " + std::to_string(chunk.count) + " elements, chunks hold " +
+                                            std::to_string(chunkSize));
+            total += chunk.count;
+            chunks.push_back(std::move(chunk));
+        }
+
+        if (total != size || (!chunks.empty() && generation == 0))
+            throw std::invalid_argument("A ChunkedVector manifest lists " + std::to_string(total) + " elements but its size is " + std::to_string(size));
+        return chunks;
+    }
+
+    std::size_t ChunkedField::loadedChunkCount() const
+    {
+        return static_cast<std::size_t>(std::count_if(m_chunks.begin(), m_chunks.end(), [](const std::shared_ptr<ChunkBase> &chunk)
+                                                      { return chunk->isLoaded(); }));
+    }
+
+    json ChunkedField::manifest(ChunkWriter &writer) const
+    {
+        // nothing to store, the empty array is shorter and reads back the same
+        if (m_chunks.empty())
+            return json::array();
+
+        json chunks = json::array();
+        std::uint64_t generation = 0;
+        for (const std::shared_ptr<ChunkBase> &chunk : m_chunks)
+        {
+            ChunkLocation location = writer.store(chunk);
+            generation = location.generation;
+            chunks.push_back({location.offset, location.length, location.checksum, chunk->count(), location.flags, chunk->digest()});
+        }
+        return {{"pack", generation}, {"size", m_size}, {"chunks", std::move(chunks)}};
+    }
+
+    std::size_t ChunkedField::hash() const
+    {
+        // element i is always in chunk i / chunkSize, so equal vectors have the same chunks with the same digests
+        std::size_t seed = std::hash<std::size_t>{}(m_size);
+        for (const std::shared_ptr<ChunkBase> &chunk : m_chunks)
+            seed ^= chunk->digest() + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+
+    bool ChunkedField::attach(const std::function<std::shared_ptr<const ChunkPack>(std::uint64_t generation)> &openPack)
+    {
+        bool attached = true;
+        for (const std::shared_ptr<ChunkBase> &chunk : m_chunks)
+        {
+            ChunkLocation location = chunk->location();
+            if (!location.stored() || location.pack)
+                continue;
+            location.pack = openPack(location.generation);
+            if (!location.pack)
+            {
+                attached = false;
+                continue;
+            }
+            chunk->setLocation(std::move(location));
+        }
+        return attached;
+    }
+
+    void ChunkedField::adoptUnchanged(const ChunkedField &previous)
+    {
+        std::size_t count = std::min(m_chunks.size(), previous.m_chunks.size());
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (m_chunks[i] == previous.m_chunks[i] || m_chunks[i]->count() != previous.m_chunks[i]->count())
+                continue;
+            if (m_chunks[i]->elements() == previous.m_chunks[i]->elements())
+                m_chunks[i] = previous.m_chunks[i];
+        }
+    }
+} // namespace datacoe
\ No newline at end of file
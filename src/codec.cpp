@@ -0,0 +1,255 @@
+#include "codec.hpp"
+#include <cryptopp/filters.h>
+#include <cryptopp/zdeflate.h>
+#include <cryptopp/zinflate.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace datacoe
+{
+    namespace
+    {
+        constexpr std::size_t MIN_MATCH = 4;
+        constexpr std::size_t MAX_OFFSET = 65535;
+        constexpr std::size_t LAST_LITERALS = 5; // matches stop this far from the end, so reads of 4 bytes stay in bounds
+        constexpr unsigned HASH_BITS = 14;
+        constexpr unsigned NIBBLE_MAX = 15;
+        // Deflate can't do better than about 1:1032, a larger original size is a corrupted or hostile payload
+        constexpr std::uint64_t MAX_RATIO = 1032;
+
+        std::uint32_t read32(const unsigned char *p)
+        {
+            std::uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        std::uint32_t hash(std::uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        void appendLength(std::string &out, std::size_t length)
+        {
+            for (; length >= 255; length -= 255)
+                out.push_back(static_cast<char>(255));
+            out.push_back(static_cast<char>(length));
+        }
+
+        void appendSequence(std::string &out, const unsigned char *literals, std::size_t literalLength, std::size_t offset, std::size_t matchLength)
+        {
+            std::size_t matchCode = matchLength == 0 ? 0 : matchLength - MIN_MATCH;
+            unsigned literalNibble = literalLength < NIBBLE_MAX ? static_cast<unsigned>(literalLength) : NIBBLE_MAX;
+            unsigned matchNibble = matchCode < NIBBLE_MAX ? static_cast<unsigned>(matchCode) : NIBBLE_MAX;
+            out.push_back(static_cast<char>((literalNibble << 4) | matchNibble));
+            if (literalNibble == NIBBLE_MAX)
+                appendLength(out, literalLength - NIBBLE_MAX);
+            out.append(reinterpret_cast<const char *>(literals), literalLength);
+
+            if (matchLength == 0)
+                return;
+            out.push_back(static_cast<char>(offset & 0xFF));
+            out.push_back(static_cast<char>(offset >> 8));
+            if (matchNibble == NIBBLE_MAX)
+                appendLength(out, matchCode - NIBBLE_MAX);
+        }
+
+        // Greedy single-probe matching, trading ratio for speed, with faster skipping through data that doesn't match
+        void compressFast(std::string_view data, std::string &out)
+        {
+            const unsigned char *src = reinterpret_cast<const unsigned char *>(data.data());
+            std::size_t size = data.size();
+            std::size_t anchor = 0;
+
+            if (size > MIN_MATCH + LAST_LITERALS)
+            {
+                std::vector<std::uint32_t> table(std::size_t(1) << HASH_BITS, 0);
+                std::size_t limit = size - LAST_LITERALS;
+                std::size_t position = 0;
+                while (position + MIN_MATCH <= limit)
+                {
+                    std::uint32_t sequence = read32(src + position);
+                    std::uint32_t &slot = table[hash(sequence)];
+                    std::size_t candidate = slot;
+                    slot = static_cast<std::uint32_t>(position);
+
+                    if (candidate >= position || position - candidate > MAX_OFFSET || read32(src + candidate) != sequence)
+                    {
+                        position += 1 + ((position - anchor) >> 6);
+                        continue;
+                    }
+
+                    std::size_t length = MIN_MATCH;
+                    while (position + length < limit && src[candidate + length] == src[position + length])
+                        length++;
+
+                    appendSequence(out, src + anchor, position - anchor, position - candidate, length);
+                    position += length;
+                    anchor = position;
+                }
+            }
+
+            appendSequence(out, src + anchor, size - anchor, 0, 0);
+        }
+
+        // every length and offset is checked against both buffers, a malformed stream never reads or writes out of bounds
+        bool decompressFast(std::string_view stream, std::string &out, std::string &error)
+        {
+            const unsigned char *in = reinterpret_cast<const unsigned char *>(stream.data());
+            const unsigned char *inEnd = in + stream.size();
+            unsigned char *dst = reinterpret_cast<unsigned char *>(out.data());
+            std::size_t written = 0;
+            std::size_t capacity = out.size();
+
+            // adds the extension bytes to a length nibble of 15, SIZE_MAX if the stream ends or the length exceeds max
+            auto readLength = [&in, inEnd](std::size_t length, std::size_t max) -> std::size_t
+            {
+                for (;;)
+                {
+                    if (in == inEnd)
+                        return SIZE_MAX;
+                    unsigned char extension = *in++;
+                    length += extension;
+                    if (length > max)
+                        return SIZE_MAX;
+                    if (extension != 255)
+                        return length;
+                }
+            };
+
+            while (in < inEnd)
+            {
+                unsigned token = *in++;
+
+                std::size_t literalLength = token >> 4;
+                if (literalLength == NIBBLE_MAX)
+                    literalLength = readLength(literalLength, capacity - written);
+                if (literalLength == SIZE_MAX || literalLength > capacity - written || literalLength > static_cast<std::size_t>(inEnd - in))
+                {
+                    error = "Literals run past the end of the data";
+                    return false;
+                }
+                std::memcpy(dst + written, in, literalLength);
+                in += literalLength;
+                written += literalLength;
+
+                if (in == inEnd)
+                    break; // the last sequence
+
+                if (inEnd - in < 2)
+                {
+                    error = "Truncated match offset";
+                    return false;
+                }
+                std::size_t offset = in[0] | (static_cast<std::size_t>(in[1]) << 8);
+                in += 2;
+                std::size_t matchLength = token & NIBBLE_MAX;
+                if (matchLength == NIBBLE_MAX)
+                    matchLength = readLength(matchLength, capacity - written);
+                if (offset == 0 || offset > written || matchLength == SIZE_MAX || matchLength + MIN_MATCH > capacity - written)
+                {
+                    error = "Match runs outside the data";
+                    return false;
+                }
+                matchLength += MIN_MATCH;
+
+                // overlapping matches repeat the bytes just written, so they are copied one at a time
+                const unsigned char *match = dst + written - offset;
+                if (offset >= matchLength)
+                    std::memcpy(dst + written, match, matchLength);
+                else
+                    for (std::size_t i = 0; i < matchLength; i++)
+                        dst[written + i] = match[i];
+                written += matchLength;
+            }
+
+            if (written != capacity)
+            {
+                error = "Decompressed " + std::to_string(written) + " bytes but expected " + std::to_string(capacity);
+                return false;
+            }
+            return true;
+        }
+    } // namespace
+
+    bool Codec::compress(Compression compression, std::string_view data, std::string &out, std::string &error)
+    {
+        for (std::size_t i = 0; i < SIZE_PREFIX; i++)
+            out.push_back(static_cast<char>((static_cast<std::uint64_t>(data.size()) >> (8 * i)) & 0xFF));
+
+        try
+        {
+            switch (compression)
+            {
+            case Compression::Fast:
+                compressFast(data, out);
+                return true;
+            case Compression::High:
+            {
+                CryptoPP::StringSource source(reinterpret_cast<const CryptoPP::byte *>(data.data()), data.size(), true,
+                                              new CryptoPP::Deflator(new CryptoPP::StringSink(out), CryptoPP::Deflator::MAX_DEFLATE_LEVEL));
+                return true;
+            }
+            default:
+                error = "Unsupported compression " + std::to_string(static_cast<int>(compression));
+                return false;
+            }
+        }
+        catch (const CryptoPP::Exception &e)
+        {
+            error = std::string("Compression failed: ") + e.what();
+            return false;
+        }
+    }
+
+    bool Codec::decompress(Compression compression, std::string_view payload, std::string &out, std::string &error)
+    {
+        if (payload.size() < SIZE_PREFIX)
+        {
+            error = "Truncated compressed data";
+            return false;
+        }
+
+        std::uint64_t originalSize = 0;
+        for (std::size_t i = 0; i < SIZE_PREFIX; i++)
+            originalSize |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(payload[i])) << (8 * i);
+        std::string_view stream = payload.substr(SIZE_PREFIX);
+        if (originalSize > MAX_RATIO * stream.size() + 64)
+        {
+            error = "Compressed data claims an impossible size of " + std::to_string(originalSize) + " bytes";
+            return false;
+        }
+
+        try
+        {
+            switch (compression)
+            {
+            case Compression::Fast:
+                out.assign(static_cast<std::size_t>(originalSize), '\0');
+                return decompressFast(stream, out, error);
+            case Compression::High:
+            {
+                out.clear();
+                out.reserve(static_cast<std::size_t>(originalSize));
+                CryptoPP::StringSource source(reinterpret_cast<const CryptoPP::byte *>(stream.data()), stream.size(), true,
+                                              new CryptoPP::Inflator(new CryptoPP::StringSink(out)));
+                if (out.size() != originalSize)
+                {
+                    error = "Decompressed " + std::to_string(out.size()) + " bytes but expected " + std::to_string(originalSize);
+                    return false;
+                }
+                return true;
+            }
+            default:
+                error = "Unsupported compression " + std::to_string(static_cast<int>(compression));
+                return false;
+            }
+        }
+        catch (const CryptoPP::Exception &e)
+        {
+            error = std::string("Decompression failed: ") + e.what();
+            return false;
+        }
+    }
+} // namespace datacoe
\ No newline at end of file
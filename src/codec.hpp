@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "datacoe/data_reader_writer.hpp"
+
+namespace datacoe
+{
+    // Internal helper, not part of the public API
+    // Compressed payload, all integers little-endian:
+    //   original size (8) | codec stream
+    // Fast stream: LZ77 sequences in the style of LZ4 blocks, each one
+    //   token (1) | [literal length extension] | literals | match offset (2) | [match length extension]
+    // the token holds the literal length in its high nibble and the match length - 4 in its low nibble,
+    // a nibble of 15 continues in extension bytes of up to 255 each. The last sequence has literals only
+    // High stream: raw Deflate (RFC 1951) from CryptoPP
+    class Codec
+    {
+    public:
+        static constexpr std::size_t SIZE_PREFIX = 8;
+
+        // appends the compressed form of data to out, returns false and fills error on failure
+        static bool compress(Compression compression, std::string_view data, std::string &out, std::string &error);
+
+        // replaces out with the decompressed payload, returns false and fills error if payload is malformed
+        static bool decompress(Compression compression, std::string_view payload, std::string &out, std::string &error);
+    };
+} // namespace datacoe
\ No newline at end of file
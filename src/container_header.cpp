@@ -0,0 +1,38 @@
+#include "container_header.hpp"
+
+namespace datacoe
+{
+    bool ContainerHeader::hasMagic(std::string_view data)
+    {
+        return data.substr(0, sizeof(MAGIC)) == std::string_view(MAGIC, sizeof(MAGIC));
+    }
+
+    bool ContainerHeader::parse(std::string_view data, ContainerHeader &header)
+    {
+        if (data.size() < SIZE || !hasMagic(data))
+            return false;
+
+        auto byteAt = [&data](std::size_t index)
+        { return static_cast<std::uint8_t>(data[index]); };
+
+        header.version = byteAt(4);
+        header.cipher = static_cast<CipherId>(byteAt(5));
+        header.flags = static_cast<std::uint16_t>(byteAt(6) | (byteAt(7) << 8));
+        header.payloadLength = 0;
+        for (std::size_t i = 0; i < 8; i++)
+            header.payloadLength |= static_cast<std::uint64_t>(byteAt(8 + i)) << (8 * i);
+
+        return true;
+    }
+
+    void ContainerHeader::appendTo(std::string &out) const
+    {
+        out.append(MAGIC, sizeof(MAGIC));
+        out.push_back(static_cast<char>(version));
+        out.push_back(static_cast<char>(cipher));
+        out.push_back(static_cast<char>(flags & 0xFF));
+        out.push_back(static_cast<char>(flags >> 8));
+        for (std::size_t i = 0; i < 8; i++)
+            out.push_back(static_cast<char>((payloadLength >> (8 * i)) & 0xFF));
+    }
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace datacoe
+{
+    // Internal helper, not part of the public API
+    // Binary save container, all integers little-endian:
+    //   magic "DCOE" (4) | format version (1) | cipher id (1) | flags (2) | payload length (8) | payload
+    // Flag bits 0-3 hold the SerializationFormat of the plaintext, bits 4-5 its Compression (see codec.hpp),
+    // bit 6 marks a summary block, the other bits are reserved and must be 0. The plaintext is compressed before it is encrypted
+    // With a summary block the bytes after the header (the payload length counts all of them) are
+    //   summary length (4) | summary | payload
+    // The summary holds a few GameData fields in the same format, never compressed, and is encrypted on its own,
+    // so it can be read without the rest of the file
+    // Cipher None payload: the serialized GameData as is
+    // AES-CBC payload: IV (16) | ciphertext, read-only, kept for saves written before AES-GCM, never has a summary
+    // AES-GCM payload: IV (12) | ciphertext | authentication tag (16), everything before it is authenticated as well
+    // (the header for the summary, the header and the summary block for the GameData)
+    enum class CipherId : std::uint8_t
+    {
+        None = 0,
+        AesCbc = 1,
+        AesGcm = 2
+    };
+
+    struct ContainerHeader
+    {
+        static constexpr char MAGIC[4] = {'D', 'C', 'O', 'E'};
+        static constexpr std::size_t SIZE = 16;
+        static constexpr std::uint8_t CURRENT_VERSION = 1;
+        static constexpr std::uint16_t FORMAT_MASK = 0x000F;
+        static constexpr std::uint16_t COMPRESSION_MASK = 0x0030;
+        static constexpr unsigned COMPRESSION_SHIFT = 4;
+        static constexpr std::uint16_t SUMMARY_FLAG = 0x0040;
+        static constexpr std::size_t SUMMARY_LENGTH_SIZE = 4;
+
+        std::uint8_t version = CURRENT_VERSION;
+        CipherId cipher = CipherId::None;
+        std::uint16_t flags = 0;
+        std::uint64_t payloadLength = 0;
+
+        // true if data starts with the container magic, the rest of the header is not validated
+        static bool hasMagic(std::string_view data);
+
+        // parses the fixed-size header at the start of data, returns false if it is missing or too short
+        static bool parse(std::string_view data, ContainerHeader &header);
+
+        // appends the SIZE encoded bytes to out
+        void appendTo(std::string &out) const;
+    };
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "crypto.hpp"
+#include <cryptopp/crc.h>
+
+namespace datacoe
+{
+    // Fixed Encryption Key (Warning: This is Insecure, I'm using it for learning purposes only!)
+    const CryptoPP::byte fixedKey[] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F};
+
+    CryptoContext::CryptoContext()
+    {
+        const CryptoPP::byte zeroIv[CryptoPP::AES::BLOCKSIZE] = {};
+        // GCM and CBC both insist on an IV when keyed, the real one is passed per file
+        gcmEncryption.SetKeyWithIV(fixedKey, CryptoPP::AES::DEFAULT_KEYLENGTH, zeroIv, GCM_IV_SIZE);
+        gcmDecryption.SetKeyWithIV(fixedKey, CryptoPP::AES::DEFAULT_KEYLENGTH, zeroIv, GCM_IV_SIZE);
+        cbcDecryption.SetKeyWithIV(fixedKey, CryptoPP::AES::DEFAULT_KEYLENGTH, zeroIv, CryptoPP::AES::BLOCKSIZE);
+    }
+
+    CryptoContext &cryptoContext()
+    {
+        thread_local CryptoContext context;
+        return context;
+    }
+
+    void sealAesGcm(std::string_view plaintext, std::string_view associatedData, std::string &out)
+    {
+        CryptoContext &context = cryptoContext();
+
+        // Generate a random IV
+        CryptoPP::byte iv[GCM_IV_SIZE];
+        context.rng.GenerateBlock(iv, GCM_IV_SIZE);
+
+        std::size_t offset = out.size();
+        out.append(reinterpret_cast<const char *>(iv), GCM_IV_SIZE);
+        out.resize(offset + GCM_IV_SIZE + plaintext.size() + GCM_TAG_SIZE);
+
+        CryptoPP::byte *ciphertext = reinterpret_cast<CryptoPP::byte *>(out.data()) + offset + GCM_IV_SIZE;
+        CryptoPP::byte *tag = ciphertext + plaintext.size();
+
+        // One pass encrypts and authenticates
+        // CryptoPP picks its AES-NI/CLMUL (or ARMv8 AES/PMULL) code paths at runtime when the CPU has them
+        context.gcmEncryption.EncryptAndAuthenticate(ciphertext, tag, GCM_TAG_SIZE, iv, GCM_IV_SIZE,
+                                                     reinterpret_cast<const CryptoPP::byte *>(associatedData.data()), associatedData.size(),
+                                                     reinterpret_cast<const CryptoPP::byte *>(plaintext.data()), plaintext.size());
+    }
+
+    bool openAesGcm(std::string_view sealed, std::string_view associatedData, std::string &plaintext)
+    {
+        if (sealed.size() < GCM_IV_SIZE + GCM_TAG_SIZE)
+            return false;
+
+        const CryptoPP::byte *iv = reinterpret_cast<const CryptoPP::byte *>(sealed.data());
+        const CryptoPP::byte *ciphertext = iv + GCM_IV_SIZE;
+        std::size_t ciphertextLength = sealed.size() - GCM_IV_SIZE - GCM_TAG_SIZE;
+        const CryptoPP::byte *tag = ciphertext + ciphertextLength;
+
+        // Decrypted straight out of the (possibly memory-mapped) file into the result
+        plaintext.assign(ciphertextLength, '\0');
+        return cryptoContext().gcmDecryption.DecryptAndVerify(reinterpret_cast<CryptoPP::byte *>(plaintext.data()), tag, GCM_TAG_SIZE, iv, GCM_IV_SIZE,
+                                                              reinterpret_cast<const CryptoPP::byte *>(associatedData.data()), associatedData.size(),
+                                                              ciphertext, ciphertextLength);
+    }
+
+    std::uint32_t crc32(std::string_view data)
+    {
+        CryptoPP::CRC32 crc;
+        crc.Update(reinterpret_cast<const CryptoPP::byte *>(data.data()), data.size());
+        CryptoPP::byte digest[CryptoPP::CRC32::DIGESTSIZE];
+        crc.Final(digest);
+        return static_cast<std::uint32_t>(digest[0]) | (static_cast<std::uint32_t>(digest[1]) << 8) |
+               (static_cast<std::uint32_t>(digest[2]) << 16) | (static_cast<std::uint32_t>(digest[3]) << 24);
+    }
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <cryptopp/aes.h>
+#include <cryptopp/gcm.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/osrng.h>
+
+namespace datacoe
+{
+    // Internal helper, not part of the public API
+    // The cipher state shared by save containers (DataReaderWriter) and journal records (Journal)
+
+    // AES-GCM parameters (96-bit IV as recommended by NIST SP 800-38D, full 128-bit tag)
+    constexpr std::size_t GCM_IV_SIZE = 12;
+    constexpr std::size_t GCM_TAG_SIZE = 16;
+
+    // Seeding the RNG from the OS and expanding the AES key schedule cost more than encrypting
+    // a small save, so every thread does both once and reuses the objects for all later calls.
+    // The ciphers only get a new IV per call, which resynchronizes them without rekeying
+    struct CryptoContext
+    {
+        CryptoPP::AutoSeededRandomPool rng;
+        CryptoPP::GCM<CryptoPP::AES>::Encryption gcmEncryption;
+        CryptoPP::GCM<CryptoPP::AES>::Decryption gcmDecryption;
+        CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption cbcDecryption;
+
+        CryptoContext();
+    };
+
+    // the calling thread's context
+    CryptoContext &cryptoContext();
+
+    // Appends IV | AES-GCM(plaintext) | tag to out, associatedData is authenticated but not written
+    // associatedData must not point into out, throws CryptoPP::Exception
+    void sealAesGcm(std::string_view plaintext, std::string_view associatedData, std::string &out);
+
+    // Reverses sealAesGcm(), returns false if sealed is too short or fails authentication
+    bool openAesGcm(std::string_view sealed, std::string_view associatedData, std::string &plaintext);
+
+    // CRC-32 (the zlib/PNG polynomial) of data
+    std::uint32_t crc32(std::string_view data);
+} // namespace datacoe
\ No newline at end of file
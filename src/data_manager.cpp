@@ -1,13 +1,50 @@
 #include "datacoe/data_manager.hpp"
 #include "datacoe/data_reader_writer.hpp"
+#include "datacoe/logger.hpp"
+#include "chunk_store.hpp"
+#include "file_buffer.hpp"
+#include "file_writer.hpp"
+#include "journal.hpp"
+#include "save_worker.hpp"
+#include <algorithm>
+#include <filesystem>
 #include <optional>
+#include <system_error>
+#include <utility>
 
 namespace datacoe
 {
-    bool DataManager::init(const std::string filename, bool encrypt)
+    namespace
     {
-        m_filename = filename;
-        m_encrypt = encrypt;
+        // share of LoadTask progress taken by reading the file, decryption and parsing are the rest
+        constexpr float LOAD_READ_SHARE = 0.7f;
+
+        std::future<bool> readyFuture(bool value)
+        {
+            std::promise<bool> done;
+            done.set_value(value);
+            return done.get_future();
+        }
+    } // namespace
+
+    // The worker only starts its thread on the first saveGameAsync()
+    DataManager::DataManager()
+        : m_snapshot(std::make_shared<const GameData>()), m_journal(std::make_unique<Journal>()), m_saveWorker(std::make_unique<SaveWorker>()) {}
+
+    DataManager::~DataManager()
+    {
+        stopAsyncLoad();
+        disableAutoSave();
+    }
+
+    bool DataManager::init(std::string filename, bool encrypt)
+    {
+        stopAsyncLoad();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_filename = std::move(filename);
+            m_encrypt = encrypt;
+        }
 
         if (!loadGame())
         {
@@ -21,35 +58,545 @@ namespace datacoe
 
     bool DataManager::saveGame()
     {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_unsavedSince.reset();
+
         if (m_gamedata.getNickname().empty())
             return true; // no need to save (guest mode), modify for you own game logic
 
-        bool result = DataReaderWriter::writeData(m_gamedata, m_filename, m_encrypt);
+        // an older background write must not land after this one
+        // m_mutex is released while waiting so setters and getters don't stall behind the write,
+        // requests are only submitted under m_mutex so the writer stays idle once it is taken back
+        while (!m_saveWorker->isIdle())
+        {
+            lock.unlock();
+            waitForPendingSaves();
+            lock.lock();
+        }
+
+        if (skipUnchangedSave())
+            return true;
+
+        // getSnapshot() must not wait for the write below
+        snapshotLocked();
+
+        std::uint64_t generation = m_generation;
+        WriteOptions options;
+        options.encryption = m_encrypt;
+        options.durability = m_durability;
+        options.format = m_format;
+        options.compression = m_compression;
+        bool result = writeSave(m_gamedata, m_filename, options, m_journalEnabled, false);
         if (result)
+        {
             m_fileEncrypted = m_encrypt;
+            m_savedGeneration = generation;
+        }
+
+        // folding the journal into the file rewrites all of it, the background writer does that instead of this call
+        bool compact = false;
+        if (result && m_journalEnabled)
+        {
+            std::lock_guard<std::mutex> journalLock(m_journalMutex);
+            compact = compactionDue();
+        }
+        if (compact)
+            submitSaveLocked();
 
         return result;
     }
 
     bool DataManager::loadGame()
     {
-        m_fileEncrypted = DataReaderWriter::isFileEncrypted(m_filename);
+        stopAsyncLoad();
+
+        // read what the background writer was asked to save
+        waitForPendingSaves();
 
-        std::optional<GameData> loadedGamedata = DataReaderWriter::readData(m_filename, m_encrypt);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // getSnapshot() must not wait for the read below
+        snapshotLocked();
+
+        // readSave() detects how the file is stored from the bytes it already read
+        ReadOptions options;
+        options.decryption = m_encrypt;
+        options.mmapThreshold = m_mmapThreshold;
+        SaveInfo info;
+        std::optional<GameData> loadedGamedata = readSave(m_filename, options, info, nullptr);
+        return applyLoadedLocked(std::move(loadedGamedata), info);
+    }
+
+    bool DataManager::applyLoadedLocked(std::optional<GameData> loadedGamedata, const SaveInfo &info)
+    {
+        m_fileEncrypted = info.encrypted;
         bool readDataSucceed = loadedGamedata.has_value();
         if (readDataSucceed)
-            m_gamedata = loadedGamedata.value();
+        {
+            m_gamedata = std::move(loadedGamedata.value());
+            publishLocked();
+            m_savedGeneration = ++m_generation; // matches the file
+            m_unsavedSince.reset();
+
+            // the file still needs its migration, or to be stored with the current encryption, format and compression
+            WriteOptions current;
+            current.encryption = m_encrypt;
+            current.format = m_format;
+            current.compression = m_compression;
+            if (info.schemaVersion != GameData::SCHEMA_VERSION || !info.matches(current))
+                markDirtyLocked();
+        }
         return readDataSucceed;
     }
 
+    LoadTask DataManager::initAsync(std::string filename, bool encrypt)
+    {
+        stopAsyncLoad();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_filename = std::move(filename);
+            m_encrypt = encrypt;
+        }
+        return startAsyncLoad(true);
+    }
+
+    LoadTask DataManager::loadGameAsync()
+    {
+        stopAsyncLoad();
+        return startAsyncLoad(false);
+    }
+
+    LoadTask DataManager::startAsyncLoad(bool newGameOnFailure)
+    {
+        auto state = std::make_shared<LoadTask::State>();
+        state->owner = this;
+        LoadTask task(state, state->result.get_future().share());
+
+        ReadOptions options;
+        std::string filename;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            options.decryption = m_encrypt;
+            options.mmapThreshold = m_mmapThreshold;
+            filename = m_filename;
+            m_loadState = state;
+            m_loadedSave.reset();
+        }
+
+        m_loadThread = std::thread([this, state, options, filename, newGameOnFailure]()
+                                   {
+            // read what the background writer was asked to save
+            waitForPendingSaves();
+
+            auto onProgress = [&state](std::size_t loaded, std::size_t total)
+            {
+                state->progress = total == 0 ? LOAD_READ_SHARE : LOAD_READ_SHARE * static_cast<float>(loaded) / static_cast<float>(total);
+                return !state->cancelRequested;
+            };
+
+            LoadedSave loaded;
+            loaded.newGameOnFailure = newGameOnFailure;
+            if (!state->cancelRequested)
+                loaded.gamedata = readSave(filename, options, loaded.info, onProgress);
+
+            // m_gamedata belongs to the owning thread, finishAsyncLoad() applies the result there
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_loadedSave = std::move(loaded);
+            }
+            state->readDone = true;
+            state->progress = 1.0f; });
+        return task;
+    }
+
+    bool DataManager::finishAsyncLoad(LoadTask::State &state, bool wait)
+    {
+        if (state.finished)
+            return true;
+        if (!wait && !state.readDone)
+            return false;
+        if (m_loadThread.joinable())
+            m_loadThread.join();
+
+        bool result = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (state.cancelRequested || !m_loadedSave)
+            {
+                DATACOE_LOG_DEBUG("DataManager::loadGameAsync() Load of " << m_filename << " cancelled");
+                state.cancelled = true;
+            }
+            else
+            {
+                LoadedSave &loaded = *m_loadedSave;
+                result = applyLoadedLocked(std::move(loaded.gamedata), loaded.info);
+
+                // can't load, like init() start a new game, change for you own game logic
+                if (!result && loaded.newGameOnFailure)
+                    newGameLocked();
+            }
+            m_loadedSave.reset();
+            m_loadState.reset();
+        }
+
+        state.owner = nullptr;
+        state.finished = true;
+        state.progress = 1.0f;
+        state.result.set_value(result);
+        return true;
+    }
+
+    void DataManager::stopAsyncLoad()
+    {
+        std::shared_ptr<LoadTask::State> state = m_loadState; // finishAsyncLoad() drops m_loadState
+        if (!state)
+            return;
+        state->cancelRequested = true;
+        finishAsyncLoad(*state, true);
+    }
+
+    void DataManager::cancelAsyncLoadLocked()
+    {
+        if (m_loadState)
+            m_loadState->cancelRequested = true;
+    }
+
+    LoadTask::LoadTask(std::shared_ptr<State> state, std::shared_future<bool> result)
+        : m_state(std::move(state)), m_result(std::move(result)) {}
+
+    float LoadTask::getProgress() const
+    {
+        return m_state ? m_state->progress.load() : 0.0f;
+    }
+
+    bool LoadTask::isReady() const
+    {
+        if (m_state && m_state->owner)
+            return m_state->owner->finishAsyncLoad(*m_state, false);
+        return m_result.valid() && m_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    bool LoadTask::get() const
+    {
+        if (m_state && m_state->owner)
+            m_state->owner->finishAsyncLoad(*m_state, true);
+        return m_result.valid() && m_result.get();
+    }
+
+    std::shared_future<bool> LoadTask::getFuture() const
+    {
+        return m_result;
+    }
+
+    void LoadTask::cancel()
+    {
+        if (m_state)
+            m_state->cancelRequested = true;
+    }
+
+    bool LoadTask::isCancelled() const
+    {
+        return m_state && m_state->cancelled;
+    }
+
+    std::future<bool> DataManager::saveGameAsync()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return saveGameAsyncLocked();
+    }
+
+    std::future<bool> DataManager::saveGameAsyncLocked()
+    {
+        m_unsavedSince.reset();
+
+        if (m_gamedata.getNickname().empty())
+            return readyFuture(true); // no need to save (guest mode), modify for you own game logic
+
+        if (skipUnchangedSave())
+            return readyFuture(true);
+
+        return submitSaveLocked();
+    }
+
+    std::future<bool> DataManager::submitSaveLocked()
+    {
+        // the current snapshot is immutable, later changes to m_gamedata publish a new one and don't affect this save
+        SaveWorker::Request request;
+        request.gamedata = snapshotLocked();
+        request.filename = m_filename;
+        request.options.encryption = m_encrypt;
+        request.options.durability = m_durability;
+        request.options.format = m_format;
+        request.options.compression = m_compression;
+        request.onComplete = [this, encrypt = m_encrypt, generation = m_generation.load()](bool result)
+        {
+            if (result)
+            {
+                m_fileEncrypted = encrypt;
+                m_savedGeneration = generation;
+            }
+        };
+        request.write = [this, journal = m_journalEnabled](const SaveWorker::Request &pending)
+        {
+            return writeSave(*pending.gamedata, pending.filename, pending.options, journal, true);
+        };
+        return m_saveWorker->submit(std::move(request));
+    }
+
+    bool DataManager::writeSave(const GameData &gamedata, const std::string &filename, const WriteOptions &options, bool journal, bool background)
+    {
+        std::lock_guard<std::mutex> lock(m_journalMutex);
+        std::string error;
+
+        bool compacting = false;
+        if (journal && m_journal->matches(filename, options))
+        {
+            if (!m_journal->append(gamedata, options.durability, error))
+                DATACOE_LOG_WARNING("DataManager::saveGame() " << error << ", writing the whole file instead");
+            else if (!background || !compactionDue())
+                return true;
+            else
+                compacting = true;
+        }
+
+        ChunkStore chunks(filename, options);
+        chunks.plan(gamedata);
+        std::optional<std::string> fileData = DataReaderWriter::encode(gamedata, options, &chunks);
+        if (!fileData)
+        {
+            DATACOE_LOG_ERROR("DataManager::saveGame() Could not encode GameData for: " << filename);
+            return false;
+        }
+        if (!FileWriter::writeAtomically(filename, *fileData, options.durability, error))
+        {
+            DATACOE_LOG_ERROR("DataManager::saveGame() " << error);
+            return false;
+        }
+        chunks.finish();
+
+        if (compacting)
+        {
+            m_compactions++;
+            DATACOE_LOG_DEBUG("DataManager::saveGame() Compacted " << m_journal->records() << " journal records into " << filename);
+        }
+
+        if (journal)
+        {
+            // the file is already safe, without a journal the next save just writes the whole file again
+            if (!m_journal->start(filename, *fileData, gamedata, options, error))
+                DATACOE_LOG_WARNING("DataManager::saveGame() " << error);
+        }
+        else if (m_journal->isOpenFor(filename))
+        {
+            // the file now holds everything the journal had
+            m_journal->discard();
+        }
+        return true;
+    }
+
+    bool DataManager::compactionDue()
+    {
+        if (!m_journal->isOpen())
+            return false;
+        double journalBytes = static_cast<double>(m_journal->size() - Journal::HEADER_SIZE);
+        return m_journal->records() >= m_journalOptions.maxRecords ||
+               journalBytes >= m_journalOptions.maxSizeRatio * static_cast<double>(m_journal->snapshotSize());
+    }
+
+    std::optional<GameData> DataManager::readSave(const std::string &filename, const ReadOptions &options, SaveInfo &info,
+                                                  const std::function<bool(std::size_t, std::size_t)> &onProgress)
+    {
+        // also keeps a background load and a background save of the same file apart
+        std::lock_guard<std::mutex> lock(m_journalMutex);
+        m_journal->close();
+
+        // Open, size and read (or map) the file once, everything else works on the bytes in memory
+        FileBuffer file;
+        if (!file.load(filename, FileBuffer::ALL, options.mmapThreshold, onProgress))
+        {
+            if (!file.stopped())
+                DATACOE_LOG_ERROR("DataManager::loadGame() " << file.error());
+            return std::nullopt;
+        }
+        if (onProgress && !onProgress(file.size(), file.size()))
+            return std::nullopt; // cancelled before decoding
+
+        std::optional<GameData> snapshot = DataReaderWriter::decode(file.view(), options, &info);
+        std::string error;
+        if (snapshot && !ChunkStore::attach(*snapshot, filename, error))
+        {
+            DATACOE_LOG_ERROR("DataManager::loadGame() " << error);
+            return std::nullopt;
+        }
+        if (!snapshot || !Journal::exists(filename))
+            return snapshot;
+
+        // the snapshot is kept as it is if the journal can't be replayed on top of it
+        // the next save of an outdated snapshot rewrites the whole file instead of appending to its journal
+        if (m_journal->replay(filename, file.view(), *snapshot) && info.schemaVersion != GameData::SCHEMA_VERSION)
+            m_journal->close();
+        return snapshot;
+    }
+
+    void DataManager::waitForPendingSaves()
+    {
+        m_saveWorker->waitUntilIdle();
+    }
+
+    std::size_t DataManager::getCoalescedSaveCount() const
+    {
+        return m_saveWorker->coalescedCount();
+    }
+
+    bool DataManager::skipUnchangedSave()
+    {
+        // a deleted save is written again even if nothing changed
+        std::error_code ec;
+        if (isDirty() || !std::filesystem::exists(m_filename, ec))
+            return false;
+
+        m_skippedSaves++;
+        DATACOE_LOG_DEBUG("DataManager::saveGame() GameData unchanged since the last save, skipping the write");
+        return true;
+    }
+
+    void DataManager::enableAutoSave(const AutoSaveOptions &options)
+    {
+        disableAutoSave();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_autoSave = options;
+        m_autoSaveEnabled = true;
+        m_autoSaveStop = false;
+        m_lastAutoSave = std::chrono::steady_clock::now();
+
+        if (!options.backgroundTimer)
+            return;
+
+        // a few checks per shortest period keep the schedule accurate without busy waiting
+        std::chrono::milliseconds pollPeriod = std::min({options.interval, options.debounce, options.maxStaleness}) / 4;
+        pollPeriod = std::max(pollPeriod, std::chrono::milliseconds(1));
+
+        m_autoSaveThread = std::thread([this, pollPeriod]()
+                                       {
+            std::unique_lock<std::mutex> timerLock(m_mutex);
+            while (!m_autoSaveStop)
+            {
+                if (m_autoSaveWakeup.wait_for(timerLock, pollPeriod, [this]() { return m_autoSaveStop; }))
+                    break;
+                autoSaveLocked(std::chrono::steady_clock::now());
+            } });
+    }
+
+    void DataManager::disableAutoSave()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_autoSaveEnabled = false;
+            m_autoSaveStop = true;
+        }
+        m_autoSaveWakeup.notify_all();
+        if (m_autoSaveThread.joinable())
+            m_autoSaveThread.join();
+    }
+
+    bool DataManager::isAutoSaveEnabled() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_autoSaveEnabled;
+    }
+
+    bool DataManager::tick()
+    {
+        if (std::shared_ptr<LoadTask::State> state = m_loadState)
+            finishAsyncLoad(*state, false);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return autoSaveLocked(std::chrono::steady_clock::now());
+    }
+
+    bool DataManager::autoSaveLocked(std::chrono::steady_clock::time_point now)
+    {
+        if (!m_autoSaveEnabled || !m_unsavedSince)
+            return false;
+
+        bool stale = now - *m_unsavedSince >= m_autoSave.maxStaleness;
+        bool settled = now - m_lastChange >= m_autoSave.debounce && now - m_lastAutoSave >= m_autoSave.interval;
+        if (!stale && !settled)
+            return false;
+
+        DATACOE_LOG_DEBUG("DataManager::tick() Auto-saving " << (stale ? "stale" : "settled") << " changes");
+        m_lastAutoSave = now;
+        m_autoSaves++;
+        saveGameAsyncLocked(); // nobody waits for the result, write failures are logged by DataReaderWriter
+        return true;
+    }
+
+    std::size_t DataManager::getAutoSaveCount() const
+    {
+        return m_autoSaves;
+    }
+
+    void DataManager::enableJournal(const JournalOptions &options)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> journalLock(m_journalMutex);
+        m_journalOptions = options;
+        m_journalEnabled = true;
+    }
+
+    void DataManager::disableJournal()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_journalEnabled)
+            markDirtyLocked(); // the journal has to be folded into the file even if GameData did not change
+        m_journalEnabled = false;
+    }
+
+    bool DataManager::isJournalEnabled() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_journalEnabled;
+    }
+
+    std::size_t DataManager::getCompactionCount() const
+    {
+        return m_compactions;
+    }
+
     void DataManager::newGame()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cancelAsyncLoadLocked();
+        newGameLocked();
+    }
+
+    void DataManager::newGameLocked()
     {
         m_gamedata = GameData();
+        publishLocked();
+        markDirtyLocked();
     }
 
     void DataManager::setGamedata(const GameData &gamedata)
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cancelAsyncLoadLocked();
+        if (gamedata == m_gamedata)
+            return;
         m_gamedata = gamedata;
+        publishLocked();
+        markDirtyLocked();
+    }
+
+    void DataManager::setGamedata(GameData &&gamedata)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cancelAsyncLoadLocked();
+        if (gamedata == m_gamedata)
+            return;
+        m_gamedata = std::move(gamedata);
+        publishLocked();
+        markDirtyLocked();
     }
 
     const GameData &DataManager::getGamedata() const
@@ -57,6 +604,54 @@ namespace datacoe
         return m_gamedata;
     }
 
+    std::shared_ptr<const GameData> DataManager::getSnapshot() const
+    {
+        if (!m_snapshotStale)
+            return std::atomic_load(&m_snapshot);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return snapshotLocked();
+    }
+
+    void DataManager::publishLocked()
+    {
+        m_snapshotStale = true;
+    }
+
+    std::shared_ptr<const GameData> DataManager::snapshotLocked() const
+    {
+        if (m_snapshotStale)
+        {
+            std::atomic_store(&m_snapshot, std::make_shared<const GameData>(m_gamedata));
+            m_snapshotStale = false;
+        }
+        return std::atomic_load(&m_snapshot);
+    }
+
+    bool DataManager::isDirty() const
+    {
+        return m_generation != m_savedGeneration;
+    }
+
+    void DataManager::markDirty()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        markDirtyLocked();
+    }
+
+    void DataManager::markDirtyLocked()
+    {
+        m_generation++;
+        m_lastChange = std::chrono::steady_clock::now();
+        if (!m_unsavedSince)
+            m_unsavedSince = m_lastChange;
+    }
+
+    std::size_t DataManager::getSkippedSaveCount() const
+    {
+        return m_skippedSaves;
+    }
+
     bool DataManager::isEncrypted() const
     {
         return m_fileEncrypted;
@@ -64,6 +659,57 @@ namespace datacoe
 
     void DataManager::setEncryption(bool encrypt)
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // the file has to be rewritten in the new format even if GameData did not change
+        if (encrypt != m_encrypt)
+            markDirtyLocked();
         m_encrypt = encrypt;
     }
+
+    void DataManager::setDurability(Durability durability)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_durability = durability;
+    }
+
+    Durability DataManager::getDurability() const
+    {
+        return m_durability;
+    }
+
+    void DataManager::setSerializationFormat(SerializationFormat format)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (format != m_format)
+            markDirtyLocked();
+        m_format = format;
+    }
+
+    SerializationFormat DataManager::getSerializationFormat() const
+    {
+        return m_format;
+    }
+
+    void DataManager::setCompression(Compression compression)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (compression != m_compression)
+            markDirtyLocked();
+        m_compression = compression;
+    }
+
+    Compression DataManager::getCompression() const
+    {
+        return m_compression;
+    }
+
+    void DataManager::setMmapThreshold(std::size_t bytes)
+    {
+        m_mmapThreshold = bytes;
+    }
+
+    std::size_t DataManager::getMmapThreshold() const
+    {
+        return m_mmapThreshold;
+    }
 } // namespace datacoe
\ No newline at end of file
@@ -1,261 +1,791 @@
 #include "datacoe/data_reader_writer.hpp"
-#include <fstream>
-#include <iostream>
-#include <filesystem>
-#include <vector>
-#include <cryptopp/aes.h>
-#include <cryptopp/modes.h>
+#include "datacoe/logger.hpp"
+#include "chunk_store.hpp"
+#include "codec.hpp"
+#include "container_header.hpp"
+#include "crypto.hpp"
+#include "file_buffer.hpp"
+#include "file_writer.hpp"
+#include "journal.hpp"
+#include "parallel_for.hpp"
+#include <algorithm>
+#include <cryptopp/cpu.h>
 #include <cryptopp/filters.h>
-#include <cryptopp/osrng.h>
 #include <cryptopp/base64.h>
 
 namespace datacoe
 {
+    // Prefix of the legacy text format, still accepted on load, new saves use the binary container
     const std::string ENCRYPTION_PREFIX = "DATACOE_ENCRYPTED";
 
-    // Fixed Encryption Key (Warning: This is Insecure, I'm using it for learning purposes only!)
-    const CryptoPP::byte fixedKey[] = {
-        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
-        0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F};
+    namespace
+    {
+        // Validates the fields of a parsed container header but the cipher and the payload length
+        // returns an error message, empty if they are valid
+        std::string checkHeader(const ContainerHeader &header)
+        {
+            if (header.version != ContainerHeader::CURRENT_VERSION)
+                return "Unsupported container version " + std::to_string(header.version);
+
+            std::uint16_t format = header.flags & ContainerHeader::FORMAT_MASK;
+            std::uint16_t compression = (header.flags & ContainerHeader::COMPRESSION_MASK) >> ContainerHeader::COMPRESSION_SHIFT;
+            if ((header.flags & ~(ContainerHeader::FORMAT_MASK | ContainerHeader::COMPRESSION_MASK | ContainerHeader::SUMMARY_FLAG)) != 0 ||
+                format > static_cast<std::uint16_t>(SerializationFormat::Bson) || compression > static_cast<std::uint16_t>(Compression::High) ||
+                ((header.flags & ContainerHeader::SUMMARY_FLAG) && header.cipher == CipherId::AesCbc))
+                return "Unsupported container flags " + std::to_string(header.flags);
+            return "";
+        }
 
-    bool DataReaderWriter::isFileEncrypted(const std::string &filename)
+        // length of the summary block of a container with one, data starts with the header and holds at least the length
+        std::uint64_t summaryLength(std::string_view data)
+        {
+            std::uint64_t length = 0;
+            for (std::size_t i = 0; i < ContainerHeader::SUMMARY_LENGTH_SIZE; i++)
+                length |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(data[ContainerHeader::SIZE + i])) << (8 * i);
+            return length;
+        }
+
+        // Splits the bytes after the header into the summary (empty without one) and the payload
+        // data may end anywhere after the summary, returns an error message, empty if the summary block is complete
+        std::string splitContainer(std::string_view data, const ContainerHeader &header, std::string_view &summary, std::string_view &payload)
+        {
+            summary = std::string_view();
+            payload = data.substr(ContainerHeader::SIZE);
+            if (!(header.flags & ContainerHeader::SUMMARY_FLAG))
+                return "";
+
+            if (payload.size() < ContainerHeader::SUMMARY_LENGTH_SIZE ||
+                summaryLength(data) > std::min<std::uint64_t>(payload.size(), header.payloadLength) - ContainerHeader::SUMMARY_LENGTH_SIZE)
+                return "Truncated summary block";
+            std::size_t length = static_cast<std::size_t>(summaryLength(data));
+            summary = payload.substr(ContainerHeader::SUMMARY_LENGTH_SIZE, length);
+            payload.remove_prefix(ContainerHeader::SUMMARY_LENGTH_SIZE + length);
+            return "";
+        }
+
+        // Validates everything in the container but the cipher, payload views the GameData after the header and
+        // the summary block, summary (optional) the summary. Returns an error message, empty if the container is well-formed
+        std::string checkContainer(std::string_view fileData, ContainerHeader &header, std::string_view &payload, std::string_view *summary = nullptr)
+        {
+            if (!ContainerHeader::parse(fileData, header))
+                return "Truncated container header";
+            std::string error = checkHeader(header);
+            if (!error.empty())
+                return error;
+
+            if (fileData.size() - ContainerHeader::SIZE != header.payloadLength)
+                return "Payload is " + std::to_string(fileData.size() - ContainerHeader::SIZE) + " bytes but the header says " +
+                       std::to_string(header.payloadLength) + " (truncated or corrupted file)";
+
+            std::string_view summaryBlock;
+            error = splitContainer(fileData, header, summaryBlock, payload);
+            if (summary)
+                *summary = summaryBlock;
+            return error;
+        }
+
+        std::string serialize(const json &j, SerializationFormat format)
+        {
+            std::string output;
+            switch (format)
+            {
+            case SerializationFormat::Cbor:
+                json::to_cbor(j, output);
+                break;
+            case SerializationFormat::MessagePack:
+                json::to_msgpack(j, output);
+                break;
+            case SerializationFormat::Bson:
+                json::to_bson(j, output);
+                break;
+            default:
+                output = j.dump();
+                break;
+            }
+            return output;
+        }
+
+        std::uint16_t containerFlags(SerializationFormat format, Compression compression)
+        {
+            return static_cast<std::uint16_t>(static_cast<std::uint16_t>(format) |
+                                              (static_cast<std::uint16_t>(compression) << ContainerHeader::COMPRESSION_SHIFT));
+        }
+
+        json deserialize(std::string_view data, SerializationFormat format)
+        {
+            switch (format)
+            {
+            case SerializationFormat::Cbor:
+                return json::from_cbor(data.begin(), data.end());
+            case SerializationFormat::MessagePack:
+                return json::from_msgpack(data.begin(), data.end());
+            case SerializationFormat::Bson:
+                return json::from_bson(data.begin(), data.end());
+            default:
+                return json::parse(data);
+            }
+        }
+
+        json::input_format_t inputFormat(SerializationFormat format)
+        {
+            switch (format)
+            {
+            case SerializationFormat::Cbor:
+                return json::input_format_t::cbor;
+            case SerializationFormat::MessagePack:
+                return json::input_format_t::msgpack;
+            case SerializationFormat::Bson:
+                return json::input_format_t::bson;
+            default:
+                return json::input_format_t::json;
+            }
+        }
+    } // namespace
+
+    bool DataReaderWriter::isEncryptedData(std::string_view data)
     {
-        if (!std::filesystem::exists(filename))
-            return false;
+        // Legacy text format: ENCRYPTION_PREFIX + Base64(IV + ciphertext)
+        if (data.substr(0, ENCRYPTION_PREFIX.size()) == ENCRYPTION_PREFIX)
+            return true;
 
-        std::ifstream file(filename, std::ios::binary);
-        if (!file.is_open())
-            return false;
+        // Binary container format
+        ContainerHeader header;
+        return ContainerHeader::parse(data, header) && header.cipher != CipherId::None;
+    }
 
-        // Read just enough bytes to check for our prefix
-        std::vector<char> header(ENCRYPTION_PREFIX.size());
-        file.read(header.data(), ENCRYPTION_PREFIX.size());
+    bool DataReaderWriter::isHardwareAccelerated()
+    {
+#if CRYPTOPP_BOOL_X64 || CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32
+        return CryptoPP::HasAESNI() && CryptoPP::HasCLMUL();
+#elif CRYPTOPP_BOOL_ARMV8
+        return CryptoPP::HasAES() && CryptoPP::HasPMULL();
+#else
+        return false;
+#endif
+    }
 
-        // Check if we read enough bytes
-        if (file.gcount() < static_cast<std::streamsize>(ENCRYPTION_PREFIX.size()))
+    bool DataReaderWriter::isFileEncrypted(const std::string &filename)
+    {
+        // Read just enough bytes to check for the legacy prefix or the container header
+        FileBuffer header;
+        if (!header.load(filename, std::max(ENCRYPTION_PREFIX.size(), ContainerHeader::SIZE)))
             return false;
 
-        // Compare with our prefix
-        return std::string(header.data(), static_cast<size_t>(file.gcount())) == ENCRYPTION_PREFIX;
+        return isEncryptedData(header.view());
     }
 
-    std::string DataReaderWriter::encrypt(const std::string &data)
+    std::string DataReaderWriter::encrypt(std::string_view data, std::uint16_t flags, std::string_view summary)
     {
         try
         {
-            // Generate a random IV
-            CryptoPP::AutoSeededRandomPool rng;
-            CryptoPP::byte iv[CryptoPP::AES::BLOCKSIZE];
-            rng.GenerateBlock(iv, CryptoPP::AES::BLOCKSIZE);
-
-            // Encrypt the data using AES in CBC mode
-            std::string ciphertext;
-            CryptoPP::CBC_Mode<CryptoPP::AES>::Encryption encryption(fixedKey, CryptoPP::AES::DEFAULT_KEYLENGTH, iv);
-            CryptoPP::StringSource ss1(data, true,
-                                       new CryptoPP::StreamTransformationFilter(encryption,
-                                                                                new CryptoPP::StringSink(ciphertext)));
-
-            // Combine IV and ciphertext
-            std::string ivString(reinterpret_cast<const char *>(iv), CryptoPP::AES::BLOCKSIZE);
-            std::string combinedData = ivString + ciphertext;
-
-            // Base64 encode the combined data
-            std::string encoded;
-            CryptoPP::StringSource ss2(combinedData, true,
-                                       new CryptoPP::Base64Encoder(
-                                           new CryptoPP::StringSink(encoded)));
+            // The whole container is written into one buffer: header | [summary block] | IV | AES-GCM(data) | tag
+            std::uint64_t summaryBlockSize = summary.empty() ? 0 : ContainerHeader::SUMMARY_LENGTH_SIZE + GCM_IV_SIZE + summary.size() + GCM_TAG_SIZE;
+            ContainerHeader header;
+            header.cipher = CipherId::AesGcm;
+            header.flags = summary.empty() ? flags : static_cast<std::uint16_t>(flags | ContainerHeader::SUMMARY_FLAG);
+            header.payloadLength = summaryBlockSize + GCM_IV_SIZE + data.size() + GCM_TAG_SIZE;
+
+            std::string output;
+            output.reserve(ContainerHeader::SIZE + static_cast<size_t>(header.payloadLength));
+            header.appendTo(output);
+
+            // Everything before a sealed part is authenticated as additional data, copied since output grows while it is read
+            std::string authenticated = output;
+            if (!summary.empty())
+            {
+                std::uint64_t sealedSize = GCM_IV_SIZE + summary.size() + GCM_TAG_SIZE;
+                for (std::size_t i = 0; i < ContainerHeader::SUMMARY_LENGTH_SIZE; i++)
+                    output.push_back(static_cast<char>((sealedSize >> (8 * i)) & 0xFF));
+                sealAesGcm(summary, authenticated, output);
+                authenticated = output;
+            }
+            sealAesGcm(data, authenticated, output);
 
-            return ENCRYPTION_PREFIX + encoded;
+            return output;
         }
         catch (const CryptoPP::Exception &e)
         {
-            std::cerr << "DataReaderWriter::encrypt() Crypto Error: " << std::endl
-                      << e.what() << std::endl;
+            DATACOE_LOG_ERROR("DataReaderWriter::encrypt() Crypto Error: " << e.what());
             return "";
         }
         catch (const std::exception &e)
         {
-            std::cerr << "DataReaderWriter::encrypt() General Error: " << std::endl
-                      << e.what() << std::endl;
+            DATACOE_LOG_ERROR("DataReaderWriter::encrypt() General Error: " << e.what());
             return "";
         }
     }
 
-    std::string DataReaderWriter::decrypt(const std::string &encodedData)
+    std::string DataReaderWriter::decrypt(std::string_view fileData)
     {
         try
         {
-            std::string dataToDecrypt = encodedData;
-            if (dataToDecrypt.substr(0, ENCRYPTION_PREFIX.size()) == ENCRYPTION_PREFIX)
+            // IV followed by the ciphertext, decrypted in place
+            std::string buffer;
+
+            if (ContainerHeader::hasMagic(fileData))
             {
-                dataToDecrypt = dataToDecrypt.substr(ENCRYPTION_PREFIX.size());
+                ContainerHeader header;
+                std::string_view payload;
+                std::string error = checkContainer(fileData, header, payload);
+                if (!error.empty())
+                {
+                    DATACOE_LOG_ERROR("DataReaderWriter::decrypt() " << error);
+                    return "";
+                }
+
+                switch (header.cipher)
+                {
+                case CipherId::AesGcm:
+                    return decryptAesGcm(fileData.substr(0, static_cast<std::size_t>(payload.data() - fileData.data())), payload);
+                case CipherId::AesCbc:
+                    // The only copy out of the (possibly memory-mapped, read-only) file
+                    buffer.assign(payload.data(), payload.size());
+                    break;
+                default:
+                    DATACOE_LOG_ERROR("DataReaderWriter::decrypt() Unsupported cipher " << static_cast<int>(header.cipher));
+                    return "";
+                }
             }
             else
             {
-                std::cerr << "DataReaderWriter::decrypt() Warning: Missing encryption prefix" << std::endl;
-                // Continue anyway in case it's an older file without the prefix
-            }
-
-            // Decode Base64
-            std::string decoded;
-            CryptoPP::StringSource ss1(dataToDecrypt, true,
-                                       new CryptoPP::Base64Decoder(
-                                           new CryptoPP::StringSink(decoded)));
+                // Legacy text format, views only until the Base64 decoder writes the buffer
+                std::string_view encoded = fileData;
+                if (encoded.substr(0, ENCRYPTION_PREFIX.size()) == ENCRYPTION_PREFIX)
+                {
+                    encoded.remove_prefix(ENCRYPTION_PREFIX.size());
+                }
+                else
+                {
+                    DATACOE_LOG_WARNING("DataReaderWriter::decrypt() Missing encryption prefix");
+                    // Continue anyway in case it's an older file without the prefix
+                }
 
-            // Check if decoded data has enough length for IV and ciphertext
-            if (decoded.length() <= CryptoPP::AES::BLOCKSIZE)
-            {
-                std::cerr << "DataReaderWriter::decrypt() Error: Decoded data too short" << std::endl;
-                return "";
+                // Decode Base64
+                buffer.reserve(encoded.size() / 4 * 3);
+                CryptoPP::StringSource ss(reinterpret_cast<const CryptoPP::byte *>(encoded.data()), encoded.size(), true,
+                                          new CryptoPP::Base64Decoder(
+                                              new CryptoPP::StringSink(buffer)));
             }
 
-            // Extract IV and ciphertext
-            CryptoPP::byte iv[CryptoPP::AES::BLOCKSIZE];
-            std::memcpy(iv, decoded.data(), CryptoPP::AES::BLOCKSIZE);
-            std::string ciphertext = decoded.substr(CryptoPP::AES::BLOCKSIZE);
-
-            // Decrypt the data
-            std::string plaintext;
-            CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption decryption(fixedKey, CryptoPP::AES::DEFAULT_KEYLENGTH, iv);
-            CryptoPP::StringSource ss2(ciphertext, true,
-                                       new CryptoPP::StreamTransformationFilter(decryption,
-                                                                                new CryptoPP::StringSink(plaintext)));
-
-            return plaintext;
+            if (!decryptAesCbcInPlace(buffer))
+                return "";
+            return buffer;
         }
         catch (const CryptoPP::Exception &e)
         {
-            std::cerr << "DataReaderWriter::decrypt() Crypto Error: " << std::endl
-                      << e.what() << std::endl;
+            DATACOE_LOG_ERROR("DataReaderWriter::decrypt() Crypto Error: " << e.what());
             return "";
         }
         catch (const std::exception &e)
         {
-            std::cerr << "DataReaderWriter::decrypt() General Error: " << std::endl
-                      << e.what() << std::endl;
+            DATACOE_LOG_ERROR("DataReaderWriter::decrypt() General Error: " << e.what());
+            return "";
+        }
+    }
+
+    std::string DataReaderWriter::decryptAesGcm(std::string_view header, std::string_view payload)
+    {
+        if (payload.size() < GCM_IV_SIZE + GCM_TAG_SIZE)
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::decrypt() Encrypted data is too short");
+            return "";
+        }
+
+        std::string plaintext;
+        bool authentic = openAesGcm(payload, header, plaintext);
+        if (!authentic)
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::decrypt() Authentication failed, the file is corrupted or was tampered with");
             return "";
         }
+
+        return plaintext;
+    }
+
+    bool DataReaderWriter::decryptAesCbcInPlace(std::string &buffer)
+    {
+        // Check if the buffer has enough length for IV and whole ciphertext blocks
+        if (buffer.length() <= CryptoPP::AES::BLOCKSIZE || buffer.length() % CryptoPP::AES::BLOCKSIZE != 0)
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::decrypt() Encrypted data has an invalid length");
+            return false;
+        }
+
+        // The plaintext overwrites the ciphertext inside the buffer
+        CryptoPP::byte *iv = reinterpret_cast<CryptoPP::byte *>(buffer.data());
+        CryptoPP::byte *ciphertext = iv + CryptoPP::AES::BLOCKSIZE;
+        size_t ciphertextLength = buffer.size() - CryptoPP::AES::BLOCKSIZE;
+
+        CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption &decryption = cryptoContext().cbcDecryption;
+        decryption.Resynchronize(iv, CryptoPP::AES::BLOCKSIZE);
+        decryption.ProcessData(ciphertext, ciphertext, ciphertextLength);
+
+        // Validate and strip the PKCS #7 padding
+        size_t padding = ciphertext[ciphertextLength - 1];
+        bool paddingValid = padding != 0 && padding <= CryptoPP::AES::BLOCKSIZE;
+        for (size_t i = ciphertextLength - (paddingValid ? padding : 0); i < ciphertextLength; i++)
+            paddingValid = paddingValid && ciphertext[i] == padding;
+
+        if (!paddingValid)
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::decrypt() Invalid block padding");
+            return false;
+        }
+
+        // Drop the padding and shift the plaintext over the IV, no reallocation
+        buffer.resize(buffer.size() - padding);
+        buffer.erase(0, CryptoPP::AES::BLOCKSIZE);
+        return true;
     }
 
     bool DataReaderWriter::writeData(const GameData &gamedata, const std::string &filename, bool encryption)
     {
+        WriteOptions options;
+        options.encryption = encryption;
+        return writeData(gamedata, filename, options);
+    }
+
+    std::optional<std::string> DataReaderWriter::encode(const GameData &gamedata, const WriteOptions &options, ChunkWriter *chunks)
+    {
+        json j;
         try
         {
-            // Convert GameData to JSON
-            std::string jsonData = gamedata.toJson().dump();
-            std::cout << "Debug: GameData to JSON: " << std::endl
-                      << jsonData << std::endl;
-
-            std::string writeableData;
+            // Convert GameData to JSON, the chunks go to their pack first so the save never references missing ones
+            j = gamedata.toJson(chunks);
+            std::string error;
+            if (chunks && !chunks->flush(error))
+            {
+                DATACOE_LOG_ERROR("DataReaderWriter::encode() " << error);
+                return std::nullopt;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::encode() " << e.what());
+            return std::nullopt;
+        }
+        json summary = reflection::summaryToJson(gamedata);
+        summary[GameData::SCHEMA_VERSION_KEY] = GameData::SCHEMA_VERSION;
+        return encodeDocument(j, options, &summary);
+    }
 
-            if(encryption)
+    std::optional<std::string> DataReaderWriter::encodeDocument(const json &j, const WriteOptions &options, const json *summary)
+    {
+        try
+        {
+            // Encode the document in the requested format
+            std::string serializedData = serialize(j, options.format);
+            DATACOE_LOG_DEBUG("DataReaderWriter::encode() Serialized GameData: " << serializedData.size() << " bytes");
+            DATACOE_LOG_TRACE("DataReaderWriter::encode() GameData JSON: " << j.dump());
+
+            // Compress before encrypting, ciphertext does not compress
+            Compression compression = options.compression;
+            std::string compressedData;
+            std::string_view plaintext = serializedData;
+            if (compression != Compression::None)
             {
-                // Encrypt the JSON data
-                std::string encryptedData = encrypt(jsonData);
-                if (encryptedData.empty())
+                std::string error;
+                if (!Codec::compress(compression, serializedData, compressedData, error))
                 {
-                    std::cerr << "DataReaderWriter::writeData() Error: Encryption failed" << std::endl;
-                    return false;
+                    DATACOE_LOG_ERROR("DataReaderWriter::encode() " << error);
+                    return std::nullopt;
                 }
-                writeableData = encryptedData;
+                DATACOE_LOG_DEBUG("DataReaderWriter::encode() Compressed " << serializedData.size() << " bytes into " << compressedData.size() << " bytes");
+
+                // small saves can grow, they are stored as is and the file says so
+                if (compressedData.size() < serializedData.size())
+                    plaintext = compressedData;
+                else
+                    compression = Compression::None;
             }
-            else // no encryption
-                writeableData = jsonData;
 
-            // Write the data to file
-            auto openmode = encryption ? std::ios::binary : std::ios::out;
-            std::ofstream file(filename, openmode);
-            if (!file.is_open())
+            // stored uncompressed, plain JSON files have no container to hold it
+            bool container = options.encryption || options.format != SerializationFormat::Json || compression != Compression::None;
+            std::string summaryData = summary && container ? serialize(*summary, options.format) : std::string();
+            std::size_t summaryBlockSize = ContainerHeader::SUMMARY_LENGTH_SIZE + summaryData.size() + (options.encryption ? GCM_IV_SIZE + GCM_TAG_SIZE : 0);
+            if (!summaryData.empty() && ContainerHeader::SIZE + summaryBlockSize > SUMMARY_READ_SIZE)
             {
-                std::cerr << "DataReaderWriter::writeData() Error: Could not open file for writing: " << filename << std::endl;
-                return false;
+                // readSummary() reads the whole save instead
+                DATACOE_LOG_DEBUG("DataReaderWriter::encode() The summary is " << summaryData.size() << " bytes, too large for a summary block");
+                summaryData.clear();
             }
 
-            file.write(writeableData.c_str(), writeableData.size());
-            if (!file.good())
+            if(options.encryption)
             {
-                std::cerr << "DataReaderWriter::writeData() Error: File write failed" << std::endl;
-                file.close();
-                return false;
+                // Encrypt the serialized data
+                std::string encryptedData = encrypt(plaintext, containerFlags(options.format, compression), summaryData);
+                if (encryptedData.empty())
+                {
+                    DATACOE_LOG_ERROR("DataReaderWriter::encode() Encryption failed");
+                    return std::nullopt;
+                }
+                return encryptedData;
             }
 
-            file.close();
-            return true;
+            if (container)
+            {
+                // Binary formats and compressed data still need the container to record them, plain JSON stays a text file
+                ContainerHeader header;
+                header.flags = containerFlags(options.format, compression);
+                header.payloadLength = plaintext.size();
+                if (!summaryData.empty())
+                {
+                    header.flags |= ContainerHeader::SUMMARY_FLAG;
+                    header.payloadLength += ContainerHeader::SUMMARY_LENGTH_SIZE + summaryData.size();
+                }
+
+                std::string containerData;
+                containerData.reserve(ContainerHeader::SIZE + static_cast<size_t>(header.payloadLength));
+                header.appendTo(containerData);
+                if (!summaryData.empty())
+                {
+                    for (std::size_t i = 0; i < ContainerHeader::SUMMARY_LENGTH_SIZE; i++)
+                        containerData.push_back(static_cast<char>((summaryData.size() >> (8 * i)) & 0xFF));
+                    containerData.append(summaryData);
+                }
+                containerData.append(plaintext);
+                return containerData;
+            }
+
+            return serializedData;
         }
         catch (const std::exception &e)
         {
-            std::cerr << "DataReaderWriter::writeData() Error: " << std::endl
-                      << e.what() << std::endl;
+            DATACOE_LOG_ERROR("DataReaderWriter::encode() " << e.what());
+            return std::nullopt;
+        }
+    }
+
+    bool DataReaderWriter::writeData(const GameData &gamedata, const std::string &filename, const WriteOptions &options)
+    {
+        ChunkStore chunks(filename, options);
+        chunks.plan(gamedata);
+        std::optional<std::string> fileData = encode(gamedata, options, &chunks);
+        if (!fileData)
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::writeData() Could not encode GameData for: " << filename);
+            return false;
+        }
+
+        // Write to a temporary file and rename it over the save, so a crash never leaves a partial file
+        std::string error;
+        if (!FileWriter::writeAtomically(filename, *fileData, options.durability, error))
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::writeData() " << error);
             return false;
         }
+
+        chunks.finish();
+        return true;
+    }
+
+    std::optional<GameData> DataReaderWriter::readData(const std::string &filename, bool decryption, bool *fileEncrypted)
+    {
+        ReadOptions options;
+        options.decryption = decryption;
+        return readData(filename, options, fileEncrypted);
+    }
+
+    std::optional<GameData> DataReaderWriter::readData(const std::string &filename, const ReadOptions &options, bool *fileEncrypted)
+    {
+        if (fileEncrypted)
+            *fileEncrypted = false;
+
+        // Open, size and read (or map) the file once, everything else works on the bytes in memory
+        FileBuffer file;
+        if (!file.load(filename, FileBuffer::ALL, options.mmapThreshold))
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::readData() " << file.error());
+            return std::nullopt;
+        }
+        DATACOE_LOG_DEBUG("DataReaderWriter::readData() " << (file.isMapped() ? "Mapped " : "Read ") << file.size() << " bytes from " << filename);
+
+        SaveInfo info;
+        std::optional<GameData> gamedata = decode(file.view(), options, &info);
+        if (fileEncrypted)
+            *fileEncrypted = info.encrypted;
+        std::string error;
+        if (gamedata && !ChunkStore::attach(*gamedata, filename, error))
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::readData() " << error);
+            return std::nullopt;
+        }
+        if (gamedata)
+            DATACOE_LOG_TRACE("DataReaderWriter::readData() GameData JSON: " << gamedata->toJson().dump());
+        return gamedata;
+    }
+
+    std::optional<GameData> DataReaderWriter::readSummary(const std::string &filename, bool decryption)
+    {
+        // The header and the summary block always fit in the first SUMMARY_READ_SIZE bytes
+        FileBuffer file;
+        if (!file.load(filename, SUMMARY_READ_SIZE))
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::readSummary() " << file.error());
+            return std::nullopt;
+        }
+
+        bool hasSummary = false;
+        std::optional<GameData> summary = decodeSummaryBlock(file.view(), hasSummary);
+        if (hasSummary)
+            return summary;
+
+        // older saves and plain JSON files are decoded whole
+        DATACOE_LOG_DEBUG("DataReaderWriter::readSummary() No current summary block in " << filename << ", reading the whole save");
+        if (!file.load(filename))
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::readSummary() " << file.error());
+            return std::nullopt;
+        }
+        return decodeSummary(file.view(), decryption);
+    }
+
+    std::optional<GameData> DataReaderWriter::decodeSummary(std::string_view fileData, bool decryption)
+    {
+        bool hasSummary = false;
+        std::optional<GameData> summary = decodeSummaryBlock(fileData, hasSummary);
+        if (hasSummary)
+            return summary;
+
+        ReadOptions options;
+        options.decryption = decryption;
+        std::optional<GameData> gamedata = decode(fileData, options);
+        if (!gamedata)
+            return std::nullopt;
+
+        // the same fields a summary block would have given
+        GameData fields;
+        reflection::summaryFromJson(reflection::summaryToJson(*gamedata), fields);
+        return fields;
     }
 
-    std::optional<GameData> DataReaderWriter::readData(const std::string &filename, bool decryption)
+    std::optional<GameData> DataReaderWriter::decodeSummaryBlock(std::string_view data, bool &hasSummary)
     {
+        hasSummary = false;
+        ContainerHeader header;
+        if (!ContainerHeader::parse(data, header) || !(header.flags & ContainerHeader::SUMMARY_FLAG))
+            return std::nullopt;
+
+        // from here on a damaged summary is a damaged save, there is nothing to fall back to
+        hasSummary = true;
+        std::string_view summary;
+        std::string_view payload;
+        std::string error = checkHeader(header);
+        if (error.empty())
+            error = splitContainer(data, header, summary, payload);
+        if (!error.empty())
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::readSummary() " << error);
+            return std::nullopt;
+        }
+
         try
         {
-            if (!std::filesystem::exists(filename))
+            std::string plaintext;
+            if (header.cipher == CipherId::AesGcm)
             {
-                std::cerr << "DataReaderWriter::readData() Error: File does not exist: " << filename << std::endl;
-                return std::nullopt;
+                if (!openAesGcm(summary, data.substr(0, ContainerHeader::SIZE), plaintext))
+                {
+                    DATACOE_LOG_ERROR("DataReaderWriter::readSummary() Authentication failed, the file is corrupted or was tampered with");
+                    return std::nullopt;
+                }
+                summary = plaintext;
             }
-
-            bool fileIsEncrypted = isFileEncrypted(filename);
-            if(fileIsEncrypted != decryption)
+            else if (header.cipher != CipherId::None)
             {
-                std::cerr << "DataReaderWriter::readData() Warning: "
-                          << (fileIsEncrypted ? "File is encrypted but decryption=false" 
-                                              : "File is not encrypted but decryption=true")
-                          << " - Adjusting decryption flag to match file state" << std::endl;
-                decryption = fileIsEncrypted;
+                DATACOE_LOG_ERROR("DataReaderWriter::readSummary() Unsupported cipher " << static_cast<int>(header.cipher));
+                return std::nullopt;
             }
 
-            // Read the data from file
-            auto openmode = decryption ? std::ios::binary : std::ios::in;
-            std::ifstream file(filename, openmode);
-            if (!file.is_open())
+            json document = deserialize(summary, static_cast<SerializationFormat>(header.flags & ContainerHeader::FORMAT_MASK));
+            auto version = document.find(GameData::SCHEMA_VERSION_KEY);
+            if (version == document.end() || *version != GameData::SCHEMA_VERSION)
             {
-                std::cerr << "DataReaderWriter::readData() Error: Could not open file for reading: " << filename << std::endl;
+                // written with other fields, the full decode migrates them
+                hasSummary = false;
                 return std::nullopt;
             }
 
-            std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-            file.close();
+            GameData gamedata;
+            reflection::summaryFromJson(document, gamedata);
+            return gamedata;
+        }
+        catch (const std::exception &e)
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::readSummary() Invalid summary block: " << e.what());
+            return std::nullopt;
+        }
+    }
+
+    bool SaveInfo::matches(const WriteOptions &options) const
+    {
+        return encrypted == options.encryption && !legacyEncryption && format == options.format && compression == options.compression;
+    }
+
+    bool DataReaderWriter::unwrap(std::string_view data, bool decryption, SaveInfo &info, std::string &buffer, std::string_view &payload)
+    {
+        bool fileIsEncrypted = isEncryptedData(data);
+        info.encrypted = fileIsEncrypted;
+        // Base64 saves predate the container
+        info.legacyEncryption = fileIsEncrypted;
 
-            std::string parseableData;
+        if(fileIsEncrypted != decryption)
+        {
+            DATACOE_LOG_WARNING("DataReaderWriter::readData() "
+                                << (fileIsEncrypted ? "File is encrypted but decryption=false"
+                                                    : "File is not encrypted but decryption=true")
+                                << " - Adjusting decryption flag to match file state");
+            decryption = fileIsEncrypted;
+        }
 
-            if(decryption)
+        // Only containers record the format, legacy and plain text saves are JSON
+        info.format = SerializationFormat::Json;
+        info.compression = Compression::None;
+        payload = data;
+        if (ContainerHeader::hasMagic(data))
+        {
+            ContainerHeader header;
+            std::string error = checkContainer(data, header, payload);
+            if (!error.empty())
             {
-                // Decrypt the data
-                std::string decryptedData = decrypt(data);
-                if (decryptedData.empty())
-                {
-                    std::cerr << "DataReaderWriter::readData() Error: Decryption failed" << std::endl;
-                    return std::nullopt;
-                }
+                DATACOE_LOG_ERROR("DataReaderWriter::readData() " << error);
+                return false;
+            }
+            info.legacyEncryption = header.cipher == CipherId::AesCbc;
+            info.format = static_cast<SerializationFormat>(header.flags & ContainerHeader::FORMAT_MASK);
+            info.compression = static_cast<Compression>((header.flags & ContainerHeader::COMPRESSION_MASK) >> ContainerHeader::COMPRESSION_SHIFT);
+        }
 
-                std::cout << "Debug: Decrypted JSON: " << std::endl
-                        << decryptedData << std::endl;
-                parseableData = decryptedData;
+        if(decryption)
+        {
+            // Decrypt the data
+            buffer = decrypt(data);
+            if (buffer.empty())
+            {
+                DATACOE_LOG_ERROR("DataReaderWriter::readData() Decryption failed");
+                return false;
             }
-            else // no decryption
-                parseableData = data;
 
-            // Parse the JSON data
-            json j = json::parse(parseableData);
-            return GameData::fromJson(j);
+            DATACOE_LOG_DEBUG("DataReaderWriter::readData() Decrypted " << data.size() << " bytes into " << buffer.size() << " bytes");
+            payload = buffer;
+        }
+
+        if (info.compression != Compression::None)
+        {
+            std::string decompressedData;
+            std::string error;
+            if (!Codec::decompress(info.compression, payload, decompressedData, error))
+            {
+                DATACOE_LOG_ERROR("DataReaderWriter::readData() " << error);
+                return false;
+            }
+            buffer = std::move(decompressedData);
+            payload = buffer;
+        }
+        return true;
+    }
+
+    std::optional<GameData> DataReaderWriter::decode(std::string_view data, const ReadOptions &options, SaveInfo *info)
+    {
+        SaveInfo found;
+        SaveInfo &saveInfo = info ? *info : found;
+        try
+        {
+            std::string buffer;
+            std::string_view payload;
+            if (!unwrap(data, options.decryption, saveInfo, buffer, payload))
+                return std::nullopt;
+
+            // Stream the serialized data straight into GameData, no json DOM in between
+            return GameData::parse(payload, inputFormat(saveInfo.format), &saveInfo.schemaVersion);
         }
         catch (const json::exception &e)
         {
-            std::cerr << "DataReaderWriter::readData() JSON Error: " << std::endl
-                      << e.what() << std::endl;
+            DATACOE_LOG_ERROR("DataReaderWriter::decode() JSON Error: " << e.what());
             return std::nullopt;
         }
         catch (const std::exception &e)
         {
-            std::cerr << "DataReaderWriter::readData() Error: " << std::endl
-                      << e.what() << std::endl;
+            DATACOE_LOG_ERROR("DataReaderWriter::decode() " << e.what());
+            return std::nullopt;
+        }
+    }
+
+    std::optional<json> DataReaderWriter::decodeDocument(std::string_view data, bool decryption)
+    {
+        try
+        {
+            std::string buffer;
+            std::string_view payload;
+            SaveInfo info;
+            if (!unwrap(data, decryption, info, buffer, payload))
+                return std::nullopt;
+
+            return deserialize(payload, info.format);
+        }
+        catch (const json::exception &e)
+        {
+            DATACOE_LOG_ERROR("DataReaderWriter::readData() JSON Error: " << e.what());
             return std::nullopt;
         }
     }
+
+    std::vector<bool> DataReaderWriter::writeMany(const std::vector<std::pair<GameData, std::string>> &jobs,
+                                                  const WriteOptions &options, std::size_t threads)
+    {
+        // std::vector<bool> packs its bits, so the threads write to one byte each and the bools are copied after
+        std::vector<unsigned char> written(jobs.size(), 0);
+        parallelFor(jobs.size(), threads, [&](std::size_t i)
+                    { written[i] = writeData(jobs[i].first, jobs[i].second, options); });
+        return std::vector<bool>(written.begin(), written.end());
+    }
+
+    std::vector<std::optional<GameData>> DataReaderWriter::readMany(const std::vector<std::string> &filenames,
+                                                                    const ReadOptions &options, std::size_t threads)
+    {
+        std::vector<std::optional<GameData>> results(filenames.size());
+        parallelFor(filenames.size(), threads, [&](std::size_t i)
+                    { results[i] = readData(filenames[i], options); });
+        return results;
+    }
+
+    std::vector<bool> DataReaderWriter::upgradeMany(const std::vector<std::string> &filenames, const WriteOptions &options, std::size_t threads)
+    {
+        std::vector<unsigned char> upToDate(filenames.size(), 0);
+        parallelFor(filenames.size(), threads, [&](std::size_t i)
+                    {
+            const std::string &filename = filenames[i];
+            // the journal's records apply to the exact bytes of the file, DataManager folds them in on its next save
+            if (Journal::exists(filename))
+            {
+                DATACOE_LOG_WARNING("DataReaderWriter::upgradeMany() Skipping " << filename << ", it has a journal");
+                return;
+            }
+
+            std::optional<GameData> gamedata;
+            SaveInfo info;
+            {
+                FileBuffer file;
+                if (!file.load(filename))
+                {
+                    DATACOE_LOG_ERROR("DataReaderWriter::upgradeMany() " << file.error());
+                    return;
+                }
+                ReadOptions readOptions;
+                readOptions.decryption = options.encryption;
+                gamedata = decode(file.view(), readOptions, &info);
+            }
+
+            std::string error;
+            if (gamedata && !ChunkStore::attach(*gamedata, filename, error))
+            {
+                DATACOE_LOG_ERROR("DataReaderWriter::upgradeMany() " << error);
+                return;
+            }
+
+            if (!gamedata)
+                return;
+            upToDate[i] = info.schemaVersion == GameData::SCHEMA_VERSION || writeData(*gamedata, filename, options); });
+        return std::vector<bool>(upToDate.begin(), upToDate.end());
+    }
 } // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "file_buffer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace datacoe
+{
+    namespace
+    {
+#ifdef _WIN32
+        using native_stat = struct _stat64;
+        int nativeOpen(const char *path) { return _open(path, _O_RDONLY | _O_BINARY); }
+        int nativeFstat(int fd, native_stat *st) { return _fstat64(fd, st); }
+        long long nativeRead(int fd, char *buffer, std::size_t count)
+        {
+            constexpr std::size_t maxChunk = 1u << 30; // _read() takes an unsigned int count
+            return _read(fd, buffer, static_cast<unsigned int>(std::min(count, maxChunk)));
+        }
+        int nativeClose(int fd) { return _close(fd); }
+#else
+        using native_stat = struct stat;
+        int nativeOpen(const char *path) { return ::open(path, O_RDONLY | O_CLOEXEC); }
+        int nativeFstat(int fd, native_stat *st) { return ::fstat(fd, st); }
+        long long nativeRead(int fd, char *buffer, std::size_t count) { return ::read(fd, buffer, count); }
+        int nativeClose(int fd) { return ::close(fd); }
+#endif
+
+        // closes the descriptor on every exit path
+        struct FdGuard
+        {
+            int fd;
+            ~FdGuard()
+            {
+                if (fd >= 0)
+                    nativeClose(fd);
+            }
+        };
+    } // namespace
+
+    FileBuffer::~FileBuffer()
+    {
+        unmap();
+    }
+
+    void FileBuffer::unmap()
+    {
+        if (!m_mapped)
+            return;
+
+#ifdef _WIN32
+        UnmapViewOfFile(m_mapped);
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+        m_mapping = nullptr;
+#else
+        ::munmap(const_cast<char *>(m_mapped), m_mappedSize);
+#endif
+        m_mapped = nullptr;
+        m_mappedSize = 0;
+    }
+
+    std::string_view FileBuffer::view() const
+    {
+        if (m_mapped)
+            return std::string_view(m_mapped, m_mappedSize);
+        return std::string_view(m_data);
+    }
+
+    bool FileBuffer::load(const std::string &filename, std::size_t maxBytes, std::size_t mmapThreshold, const ProgressCallback &onProgress)
+    {
+        unmap();
+        m_data.clear();
+        m_error.clear();
+        m_notFound = false;
+        m_stopped = false;
+
+        FdGuard guard{nativeOpen(filename.c_str())};
+        if (guard.fd < 0)
+        {
+            m_notFound = (errno == ENOENT);
+            m_error = m_notFound ? "File does not exist: " + filename
+                                 : "Could not open file for reading: " + filename + " (" + std::strerror(errno) + ")";
+            return false;
+        }
+
+        native_stat st{};
+        if (nativeFstat(guard.fd, &st) != 0)
+        {
+            m_error = "Could not stat file: " + filename + " (" + std::strerror(errno) + ")";
+            return false;
+        }
+
+        if ((st.st_mode & S_IFMT) == S_IFDIR)
+        {
+            m_error = "Path is a directory: " + filename;
+            return false;
+        }
+
+        std::size_t fileSize = static_cast<std::size_t>(st.st_size);
+
+        // Large whole-file reads are served straight from the page cache, no heap copy
+        if (maxBytes >= fileSize && fileSize > 0 && fileSize >= mmapThreshold)
+        {
+#ifdef _WIN32
+            HANDLE mapping = CreateFileMappingA(reinterpret_cast<HANDLE>(_get_osfhandle(guard.fd)), nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping)
+            {
+                void *address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, fileSize);
+                if (address)
+                {
+                    m_mapping = mapping;
+                    m_mapped = static_cast<const char *>(address);
+                    m_mappedSize = fileSize;
+                    return reportMapped(filename, onProgress);
+                }
+                CloseHandle(mapping);
+            }
+#else
+            void *address = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, guard.fd, 0);
+            if (address != MAP_FAILED)
+            {
+                // the save is decoded front to back exactly once
+                ::madvise(address, fileSize, MADV_SEQUENTIAL);
+                m_mapped = static_cast<const char *>(address);
+                m_mappedSize = fileSize;
+                return reportMapped(filename, onProgress);
+            }
+#endif
+            // mapping failed (e.g. unsupported file system), fall back to the buffered read
+        }
+
+        // Size the buffer once from fstat and read it in one go,
+        // the loop only repeats on short reads (signals, pipes, huge files on Windows) or to report progress
+        std::size_t expected = std::min(fileSize, maxBytes);
+        m_data.resize(expected);
+
+        std::size_t total = 0;
+        while (total < expected)
+        {
+            std::size_t chunk = onProgress ? std::min(expected - total, PROGRESS_CHUNK) : expected - total;
+            long long n = nativeRead(guard.fd, m_data.data() + total, chunk);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                m_error = "Could not read file: " + filename + " (" + std::strerror(errno) + ")";
+                m_data.clear();
+                return false;
+            }
+            if (n == 0) // file shrank since fstat
+                break;
+            total += static_cast<std::size_t>(n);
+
+            if (onProgress && !onProgress(total, expected))
+            {
+                m_error = "Load stopped: " + filename;
+                m_stopped = true;
+                m_data.clear();
+                return false;
+            }
+        }
+        m_data.resize(total);
+
+        return true;
+    }
+
+    bool FileBuffer::reportMapped(const std::string &filename, const ProgressCallback &onProgress)
+    {
+        if (!onProgress || onProgress(m_mappedSize, m_mappedSize))
+            return true;
+
+        m_error = "Load stopped: " + filename;
+        m_stopped = true;
+        unmap();
+        return false;
+    }
+} // namespace datacoe
\ No newline at end of file
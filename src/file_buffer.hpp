@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace datacoe
+{
+    // Internal helper, not part of the public API
+    // Loads a file with a single open, a single fstat and (usually) a single read,
+    // so callers can inspect the bytes in memory instead of reopening the file.
+    // Files at or above the mmap threshold are memory-mapped instead of copied into a heap buffer
+    class FileBuffer
+    {
+        std::string m_data;
+        const char *m_mapped = nullptr;
+        std::size_t m_mappedSize = 0;
+#ifdef _WIN32
+        void *m_mapping = nullptr; // file mapping HANDLE
+#endif
+        std::string m_error;
+        bool m_notFound = false;
+        bool m_stopped = false;
+
+        void unmap();
+
+    public:
+        static constexpr std::size_t ALL = std::numeric_limits<std::size_t>::max();
+        static constexpr std::size_t NEVER_MAP = std::numeric_limits<std::size_t>::max();
+        // buffered reads with a progress callback are split into chunks of this size
+        static constexpr std::size_t PROGRESS_CHUNK = 1024 * 1024;
+
+        // receives the bytes loaded so far and the total, returning false stops the load
+        using ProgressCallback = std::function<bool(std::size_t loaded, std::size_t total)>;
+
+        FileBuffer() = default;
+        ~FileBuffer();
+
+        FileBuffer(const FileBuffer &) = delete;
+        FileBuffer &operator=(const FileBuffer &) = delete;
+
+        // reads up to maxBytes bytes of the file (the whole file by default)
+        // whole files of at least mmapThreshold bytes are mapped, falling back to a buffered read if mapping fails
+        // onProgress (optional) is called after every chunk, and once for a mapped file
+        // returns false and fills error() if the file could not be opened or read, or onProgress stopped the load
+        bool load(const std::string &filename, std::size_t maxBytes = ALL, std::size_t mmapThreshold = NEVER_MAP,
+                  const ProgressCallback &onProgress = nullptr);
+
+        // valid until the next load() or until the FileBuffer is destroyed
+        std::string_view view() const;
+        std::size_t size() const { return view().size(); }
+        bool isMapped() const { return m_mapped != nullptr; }
+
+        const std::string &error() const { return m_error; }
+        bool notFound() const { return m_notFound; }
+        // true if the progress callback stopped the last load
+        bool stopped() const { return m_stopped; }
+
+    private:
+        // the progress report of a mapped file, which is loaded all at once
+        bool reportMapped(const std::string &filename, const ProgressCallback &onProgress);
+    };
+} // namespace datacoe
\ No newline at end of file
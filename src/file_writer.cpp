@@ -0,0 +1,221 @@
+#include "file_writer.hpp"
+#include "datacoe/logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <io.h>
+#include <process.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace datacoe
+{
+    namespace
+    {
+        std::atomic<unsigned long> g_tempCounter{0};
+
+        std::string errnoMessage()
+        {
+            return std::strerror(errno);
+        }
+
+        // unique per process and per call, so concurrent saves of the same file never share a temp file
+        std::string makeTempName(const std::string &filename)
+        {
+#ifdef _WIN32
+            long pid = static_cast<long>(_getpid());
+#else
+            long pid = static_cast<long>(::getpid());
+#endif
+            return filename + ".tmp." + std::to_string(pid) + "." + std::to_string(g_tempCounter.fetch_add(1) + 1);
+        }
+
+#ifdef _WIN32
+        int openTemp(const std::string &path) { return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE); }
+        int openAppend(const std::string &path) { return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE); }
+        long long writeSome(int fd, const char *data, std::size_t count)
+        {
+            constexpr std::size_t maxChunk = 1u << 30; // _write() takes an unsigned int count
+            return _write(fd, data, static_cast<unsigned int>(std::min(count, maxChunk)));
+        }
+        // _commit() maps to FlushFileBuffers, Windows has no data-only flush
+        bool syncData(int fd) { return _commit(fd) == 0; }
+        bool syncFull(int fd) { return _commit(fd) == 0; }
+        int closeFd(int fd) { return _close(fd); }
+        bool replaceFile(const std::string &from, const std::string &to, Durability durability)
+        {
+            DWORD flags = MOVEFILE_REPLACE_EXISTING;
+            if (durability == Durability::Full)
+                flags |= MOVEFILE_WRITE_THROUGH;
+            return MoveFileExA(from.c_str(), to.c_str(), flags) != 0;
+        }
+        // NTFS journals the rename itself, there is no directory handle to flush
+        bool syncDirectory(const std::string &) { return true; }
+#else
+        int openTemp(const std::string &path) { return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644); }
+        int openAppend(const std::string &path) { return ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644); }
+        long long writeSome(int fd, const char *data, std::size_t count) { return ::write(fd, data, count); }
+        bool syncData(int fd)
+        {
+#if defined(__APPLE__)
+            return ::fsync(fd) == 0; // no fdatasync() on macOS
+#else
+            return ::fdatasync(fd) == 0;
+#endif
+        }
+        bool syncFull(int fd)
+        {
+#if defined(__APPLE__)
+            // plain fsync() on macOS does not flush the drive's write cache
+            if (::fcntl(fd, F_FULLFSYNC) == 0)
+                return true;
+#endif
+            return ::fsync(fd) == 0;
+        }
+        int closeFd(int fd) { return ::close(fd); }
+        bool replaceFile(const std::string &from, const std::string &to, Durability) { return std::rename(from.c_str(), to.c_str()) == 0; }
+        // makes the rename itself durable
+        bool syncDirectory(const std::string &filename)
+        {
+            std::string directory = std::filesystem::path(filename).parent_path().string();
+            if (directory.empty())
+                directory = ".";
+
+            int fd = ::open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+            bool result = ::fsync(fd) == 0;
+            ::close(fd);
+            return result;
+        }
+#endif
+
+        // false with errno set if a write failed
+        bool writeAll(int fd, std::string_view data)
+        {
+            std::size_t written = 0;
+            while (written < data.size())
+            {
+                long long n = writeSome(fd, data.data() + written, data.size() - written);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+                written += static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+    } // namespace
+
+    bool FileWriter::writeAtomically(const std::string &filename, std::string_view data, Durability durability, std::string &error)
+    {
+        if (filename.empty())
+        {
+            error = "Empty filename";
+            return false;
+        }
+
+        // Respect read-only saves like an in-place write would, rename() alone would replace them
+        struct stat st{};
+        bool targetExists = ::stat(filename.c_str(), &st) == 0;
+#ifdef _WIN32
+        if (targetExists && _access(filename.c_str(), 2) != 0)
+#else
+        if (targetExists && ::access(filename.c_str(), W_OK) != 0)
+#endif
+        {
+            error = "Could not open file for writing: " + filename + " (" + errnoMessage() + ")";
+            return false;
+        }
+
+        std::string tempName = makeTempName(filename);
+        int fd = openTemp(tempName);
+        if (fd < 0)
+        {
+            error = "Could not open file for writing: " + filename + " (" + errnoMessage() + ")";
+            return false;
+        }
+
+        auto fail = [&](const std::string &message)
+        {
+            error = message + ": " + filename + " (" + errnoMessage() + ")";
+            if (fd >= 0)
+                closeFd(fd);
+            std::remove(tempName.c_str());
+            return false;
+        };
+
+#ifndef _WIN32
+        // keep the permissions of the save we are replacing
+        if (targetExists)
+            ::fchmod(fd, st.st_mode & 07777);
+#endif
+
+        if (!writeAll(fd, data))
+            return fail("File write failed");
+
+        if (durability == Durability::Data && !syncData(fd))
+            return fail("Could not flush file data");
+        if (durability == Durability::Full && !syncFull(fd))
+            return fail("Could not flush file");
+
+        int closeResult = closeFd(fd);
+        fd = -1;
+        if (closeResult != 0)
+            return fail("Could not close file");
+
+        if (!replaceFile(tempName, filename, durability))
+            return fail("Could not replace file");
+
+        // the new save is in place, only the directory entry may not be on disk yet
+        // failing here would make callers retry or roll back a save that succeeded
+        if (durability == Durability::Full && !syncDirectory(filename))
+            DATACOE_LOG_WARNING("FileWriter::writeAtomically() Could not flush directory of: " << filename << " (" << errnoMessage() << ")");
+
+        return true;
+    }
+
+    bool FileWriter::append(const std::string &filename, std::string_view data, Durability durability, std::string &error)
+    {
+        int fd = openAppend(filename);
+        if (fd < 0)
+        {
+            error = "Could not open file for appending: " + filename + " (" + errnoMessage() + ")";
+            return false;
+        }
+
+        bool result = writeAll(fd, data);
+        if (!result)
+            error = "File append failed: " + filename + " (" + errnoMessage() + ")";
+        else if ((durability == Durability::Data && !syncData(fd)) || (durability == Durability::Full && !syncFull(fd)))
+        {
+            error = "Could not flush file: " + filename + " (" + errnoMessage() + ")";
+            result = false;
+        }
+
+        if (closeFd(fd) != 0 && result)
+        {
+            error = "Could not close file: " + filename + " (" + errnoMessage() + ")";
+            result = false;
+        }
+        return result;
+    }
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "datacoe/data_reader_writer.hpp"
+
+namespace datacoe
+{
+    // Internal helper, not part of the public API
+    // Crash-safe replacement of a file: the data goes to a temporary file in the same directory,
+    // which is flushed according to the durability level and then renamed over the target.
+    // A crash at any point leaves either the complete old file or the complete new one
+    class FileWriter
+    {
+    public:
+        // returns false and fills error if the file could not be written, the target is untouched in that case
+        // A failed directory flush after the rename (Durability::Full) is logged as a warning, the new file is already in place
+        static bool writeAtomically(const std::string &filename, std::string_view data, Durability durability, std::string &error);
+
+        // Appends data to the end of the file, creating it if needed, flushed according to the durability level
+        // Not atomic: a crash can leave a prefix of data at the end of the file, readers must detect it
+        static bool append(const std::string &filename, std::string_view data, Durability durability, std::string &error);
+    };
+} // namespace datacoe
\ No newline at end of file
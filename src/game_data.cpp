@@ -1,11 +1,54 @@
 #include "datacoe/game_data.hpp"
+#include "datacoe/schema_migrations.hpp"
+#include <cstdint>
 #include <stdexcept>
+#include <string>
+#include <utility>
 
 namespace datacoe
 {
-    GameData::GameData(const std::string &nickname, const int highscore) : m_nickname(nickname), m_highscore(highscore) {}
+    namespace
+    {
+        // the schema version stored in value, null (no version key) is a save from before versions existed
+        int checkSchemaVersion(const json &value)
+        {
+            if (value.is_null())
+                return 0;
+            if (!value.is_number_integer() || value.get<std::int64_t>() < 0)
+                throw std::runtime_error(std::string("'") + GameData::SCHEMA_VERSION_KEY + "' key is invalid in the JSON object we are trying to load.");
+            if (value.get<std::int64_t>() > GameData::SCHEMA_VERSION)
+                throw std::runtime_error("The save has schema version " + value.dump() + ", newer than this game's " +
+                                         std::to_string(GameData::SCHEMA_VERSION));
+            return value.get<int>();
+        }
+
+        int schemaVersionOf(const json &j)
+        {
+            if (!j.is_object())
+                return GameData::SCHEMA_VERSION; // not a save at all, fails the field checks
+            auto it = j.find(GameData::SCHEMA_VERSION_KEY);
+            return checkSchemaVersion(it == j.end() ? json() : *it);
+        }
 
-    void GameData::setNickname(const std::string &nickname) { m_nickname = nickname; }
+        json decodeJson(std::string_view data, json::input_format_t format)
+        {
+            switch (format)
+            {
+            case json::input_format_t::cbor:
+                return json::from_cbor(data.begin(), data.end());
+            case json::input_format_t::msgpack:
+                return json::from_msgpack(data.begin(), data.end());
+            case json::input_format_t::bson:
+                return json::from_bson(data.begin(), data.end());
+            default:
+                return json::parse(data);
+            }
+        }
+    } // namespace
+
+    GameData::GameData(std::string nickname, const int highscore) : m_nickname(std::move(nickname)), m_highscore(highscore) {}
+
+    void GameData::setNickname(std::string nickname) { m_nickname = std::move(nickname); }
 
     void GameData::setHighscore(int highscore) { m_highscore = highscore; }
 
@@ -13,34 +56,59 @@ namespace datacoe
 
     int GameData::getHighscore() const { return m_highscore; }
 
-    json GameData::toJson() const
+    bool GameData::operator==(const GameData &other) const { return reflection::equal(*this, other); }
+
+    bool GameData::operator!=(const GameData &other) const { return !(*this == other); }
+
+    json GameData::diff(const GameData &from) const { return reflection::diff(from, *this); }
+
+    std::size_t GameData::hash() const { return reflection::hash(*this); }
+
+    json GameData::toJson(ChunkWriter *chunks) const
     {
-        json j;
-        j["nickname"] = m_nickname;
-        j["highscore"] = m_highscore;
+        json j = reflection::toJson(*this, chunks);
+        j[SCHEMA_VERSION_KEY] = SCHEMA_VERSION;
         return j;
     }
 
     GameData GameData::fromJson(const json &j)
     {
-        std::string nickname;
-        int highscore;
-        if (j.contains("nickname") && j["nickname"].is_string())
-        {
-            try { nickname = j["nickname"].get<std::string>(); }
-            catch (const json::exception &) { throw; }
-        }
-        else
-            throw std::runtime_error("'nickname' key is missing or invalid in the JSON object we are trying to load.");
+        int version = schemaVersionOf(j);
+        if (version == SCHEMA_VERSION)
+            return reflection::fromJson<GameData>(j);
+
+        json migrated = j;
+        SchemaMigrations::migrate(migrated, version);
+        return reflection::fromJson<GameData>(std::move(migrated));
+    }
+
+    GameData GameData::fromJson(json &&j)
+    {
+        int version = schemaVersionOf(j);
+        if (version != SCHEMA_VERSION)
+            SchemaMigrations::migrate(j, version);
+        return reflection::fromJson<GameData>(std::move(j));
+    }
+
+    GameData GameData::parse(std::string_view data, json::input_format_t format, int *schemaVersion)
+    {
+        GameData gamedata;
+        reflection::SaxReader<GameData> reader(gamedata, SCHEMA_VERSION_KEY);
+        json::sax_parse(data.data(), data.data() + data.size(), &reader, format);
 
-        if (j.contains("highscore") && j["highscore"].is_number_integer())
+        int version = checkSchemaVersion(reader.extra());
+        if (schemaVersion)
+            *schemaVersion = version;
+        if (version == SCHEMA_VERSION)
         {
-            try { highscore = j["highscore"].get<int>(); }
-            catch (const json::exception &) { throw; }
+            reader.checkComplete();
+            return gamedata;
         }
-        else
-            throw std::runtime_error("'highscore' key is missing or invalid in the JSON object we are trying to load.");
 
-        return GameData(nickname, highscore);
+        // An older save, its fields may not fit the current list, so it is decoded again as json and migrated
+        json save = decodeJson(data, format);
+        if (save.is_object()) // anything else is not a save and fails the field checks below
+            SchemaMigrations::migrate(save, version);
+        return reflection::fromJson<GameData>(std::move(save));
     }
 } // namespace datacoe
\ No newline at end of file
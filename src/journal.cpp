@@ -0,0 +1,291 @@
+#include "journal.hpp"
+#include "datacoe/logger.hpp"
+#include "crypto.hpp"
+#include "file_buffer.hpp"
+#include "file_writer.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+
+namespace datacoe
+{
+    namespace
+    {
+        constexpr char MAGIC[4] = {'D', 'C', 'O', 'J'};
+        constexpr std::uint8_t FLAG_ENCRYPTED = 0x01;
+
+        void appendUint(std::string &out, std::uint64_t value, std::size_t bytes)
+        {
+            for (std::size_t i = 0; i < bytes; i++)
+                out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+
+        std::uint64_t readUint(std::string_view data, std::size_t offset, std::size_t bytes)
+        {
+            std::uint64_t value = 0;
+            for (std::size_t i = 0; i < bytes; i++)
+                value |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(data[offset + i])) << (8 * i);
+            return value;
+        }
+
+        std::string makeHeader(std::string_view snapshotData, const WriteOptions &options)
+        {
+            std::uint8_t flags = static_cast<std::uint8_t>(static_cast<std::uint8_t>(options.format) << 4);
+            if (options.encryption)
+                flags |= FLAG_ENCRYPTED;
+
+            std::string header(MAGIC, sizeof(MAGIC));
+            header.push_back(static_cast<char>(Journal::CURRENT_VERSION));
+            header.push_back(static_cast<char>(flags));
+            header.push_back(static_cast<char>(options.compression));
+            appendUint(header, 0, 1);
+            appendUint(header, snapshotData.size(), 8);
+            appendUint(header, crc32(snapshotData), 4);
+            return header;
+        }
+
+        // the additional data that ties a record to its journal and its position in it
+        std::string associatedData(const std::string &header, std::size_t record)
+        {
+            std::string data = header;
+            appendUint(data, record, 4);
+            return data;
+        }
+    } // namespace
+
+    std::string Journal::pathFor(const std::string &saveFilename)
+    {
+        return saveFilename + EXTENSION;
+    }
+
+    bool Journal::exists(const std::string &saveFilename)
+    {
+        std::error_code ec;
+        return std::filesystem::exists(pathFor(saveFilename), ec);
+    }
+
+    void Journal::remove(const std::string &saveFilename)
+    {
+        std::remove(pathFor(saveFilename).c_str());
+    }
+
+    bool Journal::start(const std::string &saveFilename, std::string_view snapshotData, const GameData &state, const WriteOptions &options, std::string &error)
+    {
+        close();
+
+        std::string path = pathFor(saveFilename);
+        std::string header = makeHeader(snapshotData, options);
+        if (!FileWriter::writeAtomically(path, header, options.durability, error))
+            return false;
+
+        m_path = std::move(path);
+        m_header = std::move(header);
+        m_state = state;
+        m_options = options;
+        m_snapshotSize = snapshotData.size();
+        m_size = m_fileSize = HEADER_SIZE;
+        m_open = true;
+        return true;
+    }
+
+    bool Journal::replay(const std::string &saveFilename, std::string_view snapshotData, GameData &state)
+    {
+        close();
+
+        std::string path = pathFor(saveFilename);
+        FileBuffer file;
+        if (!file.load(path))
+        {
+            if (!file.notFound())
+                DATACOE_LOG_WARNING("Journal::replay() " << file.error());
+            return false;
+        }
+
+        std::string_view data = file.view();
+        if (data.size() < HEADER_SIZE || data.substr(0, sizeof(MAGIC)) != std::string_view(MAGIC, sizeof(MAGIC)) ||
+            static_cast<std::uint8_t>(data[4]) != CURRENT_VERSION)
+        {
+            DATACOE_LOG_WARNING("Journal::replay() Ignoring unreadable journal: " << path);
+            return false;
+        }
+
+        std::uint8_t flags = static_cast<std::uint8_t>(data[5]);
+        WriteOptions options;
+        options.encryption = (flags & FLAG_ENCRYPTED) != 0;
+        options.format = static_cast<SerializationFormat>(flags >> 4);
+        options.compression = static_cast<Compression>(data[6]);
+
+        // the snapshot was rewritten after this journal was started, its changes are already in it
+        std::string header = makeHeader(snapshotData, options);
+        if (data.substr(0, HEADER_SIZE) != header)
+        {
+            DATACOE_LOG_INFO("Journal::replay() Ignoring journal of an older snapshot: " << path);
+            return false;
+        }
+
+        // built on the first record, a journal without records leaves state and its unloaded chunks alone
+        json replayed;
+        std::size_t records = 0;
+        std::size_t offset = HEADER_SIZE;
+        while (data.size() - offset >= RECORD_HEADER_SIZE)
+        {
+            std::uint64_t length = readUint(data, offset, 4);
+            std::uint32_t checksum = static_cast<std::uint32_t>(readUint(data, offset + 4, 4));
+            if (length > data.size() - offset - RECORD_HEADER_SIZE)
+                break; // torn append
+            std::string_view body = data.substr(offset + RECORD_HEADER_SIZE, static_cast<std::size_t>(length));
+            if (crc32(body) != checksum)
+                break;
+
+            std::string plaintext;
+            if (options.encryption)
+            {
+                if (!openAesGcm(body, associatedData(header, records), plaintext))
+                {
+                    DATACOE_LOG_ERROR("Journal::replay() Authentication of record " << records << " failed, the journal is corrupted or was tampered with");
+                    break;
+                }
+            }
+            else
+            {
+                plaintext.assign(body);
+            }
+
+            try
+            {
+                if (records == 0)
+                    replayed = state.toJson();
+                replayed = replayed.patch(json::parse(plaintext));
+            }
+            catch (const std::exception &e)
+            {
+                DATACOE_LOG_ERROR("Journal::replay() Invalid record " << records << ": " << e.what());
+                break;
+            }
+
+            offset += RECORD_HEADER_SIZE + static_cast<std::size_t>(length);
+            records++;
+        }
+
+        if (offset < data.size())
+            DATACOE_LOG_WARNING("Journal::replay() Dropped " << (data.size() - offset) << " bytes after record " << records << " of: " << path);
+        DATACOE_LOG_DEBUG("Journal::replay() Applied " << records << " records from: " << path);
+
+        try
+        {
+            if (records > 0)
+            {
+                // the replayed state holds every chunk in memory, the ones the records left alone go back to their pack
+                GameData newState = GameData::fromJson(std::move(replayed));
+                reflection::adoptUnchangedChunks(newState, state);
+                state = std::move(newState);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            DATACOE_LOG_ERROR("Journal::replay() The journal does not replay into valid GameData, ignoring it: " << e.what());
+            return false;
+        }
+
+        m_path = std::move(path);
+        m_header = std::move(header);
+        m_state = state;
+        m_options = options;
+        m_snapshotSize = snapshotData.size();
+        m_records = records;
+        m_size = offset;
+        m_fileSize = data.size();
+        m_open = true;
+        return true;
+    }
+
+    bool Journal::append(const GameData &state, Durability durability, std::string &error)
+    {
+        if (!m_open)
+        {
+            error = "No open journal";
+            return false;
+        }
+
+        json patch = state.diff(m_state);
+        if (patch.empty())
+            return true;
+
+        try
+        {
+            std::string plaintext = patch.dump();
+            std::string body;
+            if (m_options.encryption)
+                sealAesGcm(plaintext, associatedData(m_header, m_records), body);
+            else
+                body = std::move(plaintext);
+
+            std::string record;
+            record.reserve(RECORD_HEADER_SIZE + body.size());
+            appendUint(record, body.size(), 4);
+            appendUint(record, crc32(body), 4);
+            record.append(body);
+
+            // a torn record from an earlier crash or failed append would hide everything written after it
+            if (m_fileSize != m_size)
+            {
+                std::error_code ec;
+                std::filesystem::resize_file(m_path, m_size, ec);
+                if (ec)
+                {
+                    error = "Could not truncate journal: " + m_path + " (" + ec.message() + ")";
+                    close();
+                    return false;
+                }
+                m_fileSize = m_size;
+            }
+
+            if (!FileWriter::append(m_path, record, durability, error))
+            {
+                close();
+                return false;
+            }
+
+            m_state = state;
+            m_records++;
+            m_size += record.size();
+            m_fileSize = m_size;
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            error = std::string("Journal append failed: ") + e.what();
+            close();
+            return false;
+        }
+    }
+
+    bool Journal::matches(const std::string &saveFilename, const WriteOptions &options) const
+    {
+        return isOpenFor(saveFilename) && m_options.encryption == options.encryption && m_options.format == options.format &&
+               m_options.compression == options.compression;
+    }
+
+    bool Journal::isOpenFor(const std::string &saveFilename) const
+    {
+        return m_open && m_path == pathFor(saveFilename);
+    }
+
+    void Journal::close()
+    {
+        m_open = false;
+        m_path.clear();
+        m_header.clear();
+        m_state = GameData();
+        m_records = 0;
+        m_size = m_fileSize = 0;
+        m_snapshotSize = 0;
+    }
+
+    void Journal::discard()
+    {
+        if (m_open)
+            std::remove(m_path.c_str());
+        close();
+    }
+} // namespace datacoe
\ No newline at end of file
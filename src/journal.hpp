@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "datacoe/data_reader_writer.hpp"
+#include "datacoe/game_data.hpp"
+
+namespace datacoe
+{
+    // Internal helper, not part of the public API
+    // Append-only log of changes on top of a save file (the snapshot), kept next to it as <save>.journal
+    // All integers little-endian:
+    //   header: magic "DCOJ" (4) | version (1) | flags (1) | compression (1) | reserved (1) | snapshot size (8) | snapshot CRC-32 (4)
+    //   record: body length (4) | body CRC-32 (4) | body
+    // The low flag bit is set when records are encrypted, the high nibble holds the snapshot's SerializationFormat.
+    // The compression byte is the Compression setting the snapshot was written with, records are small patches and never compressed.
+    // A body is the JSON Patch (RFC 6902) from the previous state to the saved one (GameData::diff()), AES-GCM sealed when encrypted
+    // with the header and the record number as additional data, so records can't be reordered or moved between journals.
+    // The header names the snapshot the records apply to, a journal left behind by an older snapshot is ignored.
+    // A crash during an append leaves a torn last record, replay() stops before it and the next append cuts it off
+    class Journal
+    {
+        std::string m_path;
+        std::string m_header;       // encoded header of the open journal, part of every record's additional data
+        GameData m_state;           // state after the last record, the base of the next diff
+        WriteOptions m_options;     // encryption, format and compression of the snapshot
+        std::uint64_t m_snapshotSize = 0;
+        std::size_t m_records = 0;
+        std::uint64_t m_size = 0;     // end of the last valid record
+        std::uint64_t m_fileSize = 0; // larger than m_size after a torn append
+        bool m_open = false;
+
+    public:
+        static constexpr const char *EXTENSION = ".journal";
+        static constexpr std::size_t HEADER_SIZE = 20;
+        static constexpr std::size_t RECORD_HEADER_SIZE = 8;
+        static constexpr std::uint8_t CURRENT_VERSION = 1;
+
+        static std::string pathFor(const std::string &saveFilename);
+        // true if saveFilename has a journal file, whether or not it belongs to the current snapshot
+        static bool exists(const std::string &saveFilename);
+        static void remove(const std::string &saveFilename);
+
+        // Replaces any journal of saveFilename with an empty one for the snapshot just written
+        // snapshotData are the exact bytes of the save file, state its content
+        bool start(const std::string &saveFilename, std::string_view snapshotData, const GameData &state, const WriteOptions &options, std::string &error);
+
+        // Applies the journal records of saveFilename on top of state, the content of snapshotData
+        // returns false, leaving state untouched, if there is no journal for this snapshot or it does not replay into valid GameData
+        // On success the journal is open and later append() calls continue it
+        bool replay(const std::string &saveFilename, std::string_view snapshotData, GameData &state);
+
+        // Appends the changes from the last saved state to state, returns true without writing if nothing changed
+        // On failure the journal is closed, the caller has to write a snapshot instead
+        bool append(const GameData &state, Durability durability, std::string &error);
+
+        // true if the open journal continues saveFilename written with options
+        bool matches(const std::string &saveFilename, const WriteOptions &options) const;
+        bool isOpenFor(const std::string &saveFilename) const;
+        void close();
+        // closes the journal and deletes its file, for when the snapshot was rewritten without starting a new one
+        void discard();
+
+        bool isOpen() const { return m_open; }
+        std::size_t records() const { return m_records; }
+        std::uint64_t size() const { return m_size; }
+        std::uint64_t snapshotSize() const { return m_snapshotSize; }
+    };
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "datacoe/logger.hpp"
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+namespace datacoe
+{
+    namespace
+    {
+        std::mutex g_sinkMutex;
+        Logger::Sink g_sink;
+        std::atomic<LogLevel> g_level{Logger::COMPILE_TIME_MIN_LEVEL};
+
+        // Default sink, no std::endl so logging never forces a flush on the hot path
+        void stdioSink(LogLevel level, const std::string &message)
+        {
+            std::ostream &out = level >= LogLevel::Warning ? std::cerr : std::cout;
+            out << "[datacoe][" << Logger::levelName(level) << "] " << message << '\n';
+        }
+    } // namespace
+
+    void Logger::setSink(Sink sink)
+    {
+        std::lock_guard<std::mutex> lock(g_sinkMutex);
+        g_sink = std::move(sink);
+    }
+
+    void Logger::setLevel(LogLevel level)
+    {
+        g_level.store(level, std::memory_order_relaxed);
+    }
+
+    LogLevel Logger::getLevel()
+    {
+        return g_level.load(std::memory_order_relaxed);
+    }
+
+    bool Logger::isEnabled(LogLevel level)
+    {
+        return level != LogLevel::Off && level >= COMPILE_TIME_MIN_LEVEL && level >= getLevel();
+    }
+
+    void Logger::write(LogLevel level, const std::string &message)
+    {
+        if (!isEnabled(level))
+            return;
+
+        std::lock_guard<std::mutex> lock(g_sinkMutex);
+        if (g_sink)
+            g_sink(level, message);
+        else
+            stdioSink(level, message);
+    }
+
+    const char *Logger::levelName(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::Trace:
+            return "TRACE";
+        case LogLevel::Debug:
+            return "DEBUG";
+        case LogLevel::Info:
+            return "INFO";
+        case LogLevel::Warning:
+            return "WARNING";
+        case LogLevel::Error:
+            return "ERROR";
+        default:
+            return "OFF";
+        }
+    }
+} // namespace datacoe
\ No newline at end of file
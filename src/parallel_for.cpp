@@ -0,0 +1,49 @@
+#include "parallel_for.hpp"
+#include "datacoe/logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace datacoe
+{
+    std::size_t defaultThreadCount()
+    {
+        // hardware_concurrency() may return 0 when it can't tell
+        return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    void parallelFor(std::size_t count, std::size_t threads, const std::function<void(std::size_t)> &body)
+    {
+        if (threads == 0)
+            threads = defaultThreadCount();
+        threads = std::min(threads, count);
+
+        std::atomic<std::size_t> next{0};
+        auto work = [&]()
+        {
+            for (std::size_t i = next++; i < count; i = next++)
+                body(i);
+        };
+
+        std::vector<std::thread> helpers;
+        helpers.reserve(threads > 0 ? threads - 1 : 0);
+        for (std::size_t t = 1; t < threads; t++)
+        {
+            // the threads already started must still be joined, they and this one share the rest of the work
+            try
+            {
+                helpers.emplace_back(work);
+            }
+            catch (const std::system_error &e)
+            {
+                DATACOE_LOG_WARNING("parallelFor() Could not start a thread, continuing with " << helpers.size() + 1 << " (" << e.what() << ")");
+                break;
+            }
+        }
+        work();
+        for (std::thread &helper : helpers)
+            helper.join();
+    }
+} // namespace datacoe
\ No newline at end of file
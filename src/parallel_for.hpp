@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace datacoe
+{
+    // Internal helper, not part of the public API
+    // Runs body(0) .. body(count - 1) on up to threads threads (0 = one per core), the calling thread being one of them.
+    // Threads take the next index from a shared counter, so slow items don't leave the other threads idle.
+    // If the system can't start another thread, the ones already running finish the work.
+    // body must not throw and must only touch state that belongs to its index
+    void parallelFor(std::size_t count, std::size_t threads, const std::function<void(std::size_t)> &body);
+
+    // the number of threads parallelFor() uses for threads = 0
+    std::size_t defaultThreadCount();
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "datacoe/save_slots.hpp"
+#include "datacoe/logger.hpp"
+#include "chunk_store.hpp"
+#include "crypto.hpp"
+#include "file_buffer.hpp"
+#include "file_writer.hpp"
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <string_view>
+#include <sys/stat.h>
+#include <system_error>
+
+namespace datacoe
+{
+    namespace
+    {
+        constexpr int INDEX_VERSION = 1;
+        // With encryption the index is MAGIC | IV | AES-GCM(index JSON) | tag, it holds the nicknames and highscores
+        // the encrypted slots protect. Authenticating the magic keeps a plain index from being mistaken for a sealed one
+        constexpr std::string_view SEALED_INDEX_MAGIC = "DCOEIDX1";
+
+        // std::filesystem::file_time_type has no portable conversion to system time before C++20
+        std::int64_t modificationTime(const std::string &path)
+        {
+            struct stat st{};
+            return ::stat(path.c_str(), &st) == 0 ? static_cast<std::int64_t>(st.st_mtime) : 0;
+        }
+    } // namespace
+
+    bool SaveSlots::isValidName(const std::string &name)
+    {
+        if (name.empty())
+            return false;
+        for (char c : name)
+        {
+            bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+            if (!valid)
+                return false;
+        }
+        return true;
+    }
+
+    std::string SaveSlots::pathOf(const std::string &file) const
+    {
+        return (std::filesystem::path(m_directory) / file).string();
+    }
+
+    std::string SaveSlots::slotPath(const std::string &name) const
+    {
+        return pathOf(name + SLOT_EXTENSION);
+    }
+
+    bool SaveSlots::open(const std::string &directory, const WriteOptions &options)
+    {
+        m_directory = directory;
+        m_options = options;
+        m_slots.clear();
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec)
+        {
+            DATACOE_LOG_ERROR("SaveSlots::open() Could not create directory: " << directory << " (" << ec.message() << ")");
+            return false;
+        }
+
+        bool sealed = false;
+        if (!loadIndex(sealed))
+        {
+            DATACOE_LOG_WARNING("SaveSlots::open() Rebuilding the slot index of: " << directory);
+            return rebuildIndex();
+        }
+        // an index written with the other encryption setting is stored the current way right away
+        if (sealed != m_options.encryption && !writeIndex())
+            return false;
+
+        // A save or remove was interrupted after the marker was written, its index entry may be stale
+        FileBuffer pending;
+        if (pending.load(pathOf(PENDING_FILENAME)))
+        {
+            std::string name(pending.view());
+            DATACOE_LOG_WARNING("SaveSlots::open() Repairing the index entry of slot '" << name << "' after an interrupted save");
+            if (isValidName(name))
+                refreshSlot(name);
+            if (!writeIndex())
+                return false;
+            removePendingMarker();
+        }
+
+        return true;
+    }
+
+    bool SaveSlots::loadIndex(bool &sealed)
+    {
+        FileBuffer file;
+        if (!file.load(pathOf(INDEX_FILENAME)))
+            return false;
+
+        std::string_view contents = file.view();
+        std::string opened;
+        sealed = contents.substr(0, SEALED_INDEX_MAGIC.size()) == SEALED_INDEX_MAGIC;
+        if (sealed)
+        {
+            if (!openAesGcm(contents.substr(SEALED_INDEX_MAGIC.size()), SEALED_INDEX_MAGIC, opened))
+            {
+                DATACOE_LOG_WARNING("SaveSlots::loadIndex() Authentication of the slot index failed");
+                return false;
+            }
+            contents = opened;
+        }
+
+        try
+        {
+            json index = json::parse(contents);
+            if (index.value("version", 0) != INDEX_VERSION)
+                return false;
+
+            for (const json &entry : index.at("slots"))
+            {
+                SlotInfo info;
+                info.name = entry.at("name").get<std::string>();
+                info.nickname = entry.at("nickname").get<std::string>();
+                info.highscore = entry.at("highscore").get<int>();
+                info.timestamp = entry.at("timestamp").get<std::int64_t>();
+                info.size = entry.at("size").get<std::uint64_t>();
+                info.checksum = entry.at("checksum").get<std::uint32_t>();
+                if (isValidName(info.name))
+                    m_slots[info.name] = std::move(info);
+            }
+            return true;
+        }
+        catch (const json::exception &e)
+        {
+            DATACOE_LOG_WARNING("SaveSlots::loadIndex() Invalid slot index: " << e.what());
+            m_slots.clear();
+            return false;
+        }
+    }
+
+    bool SaveSlots::writeIndex()
+    {
+        json slots = json::array();
+        for (const auto &[name, info] : m_slots)
+        {
+            slots.push_back({{"name", info.name},
+                             {"nickname", info.nickname},
+                             {"highscore", info.highscore},
+                             {"timestamp", info.timestamp},
+                             {"size", info.size},
+                             {"checksum", info.checksum}});
+        }
+        json index = {{"version", INDEX_VERSION}, {"slots", std::move(slots)}};
+
+        std::string data = index.dump();
+        if (m_options.encryption)
+        {
+            std::string sealed(SEALED_INDEX_MAGIC);
+            try
+            {
+                sealAesGcm(data, SEALED_INDEX_MAGIC, sealed);
+            }
+            catch (const std::exception &e)
+            {
+                DATACOE_LOG_ERROR("SaveSlots::writeIndex() Encryption failed: " << e.what());
+                return false;
+            }
+            data = std::move(sealed);
+        }
+
+        std::string error;
+        if (!FileWriter::writeAtomically(pathOf(INDEX_FILENAME), data, m_options.durability, error))
+        {
+            DATACOE_LOG_ERROR("SaveSlots::writeIndex() " << error);
+            return false;
+        }
+        return true;
+    }
+
+    bool SaveSlots::writePendingMarker(const std::string &name)
+    {
+        std::string error;
+        if (!FileWriter::writeAtomically(pathOf(PENDING_FILENAME), name, m_options.durability, error))
+        {
+            DATACOE_LOG_ERROR("SaveSlots::writePendingMarker() " << error);
+            return false;
+        }
+        return true;
+    }
+
+    void SaveSlots::removePendingMarker()
+    {
+        std::remove(pathOf(PENDING_FILENAME).c_str());
+    }
+
+    bool SaveSlots::refreshSlot(const std::string &name)
+    {
+        std::string path = slotPath(name);
+        FileBuffer file;
+        if (!file.load(path))
+        {
+            m_slots.erase(name);
+            return file.notFound(); // a missing slot is simply not listed
+        }
+
+        // the size and checksum need the whole file, the slot's fields only its summary block
+        std::optional<GameData> gamedata = DataReaderWriter::decodeSummary(file.view(), m_options.encryption);
+        if (!gamedata)
+        {
+            DATACOE_LOG_WARNING("SaveSlots::refreshSlot() Slot '" << name << "' is unreadable and was left out of the index");
+            m_slots.erase(name);
+            return false;
+        }
+
+        SlotInfo info;
+        info.name = name;
+        info.nickname = gamedata->getNickname();
+        info.highscore = gamedata->getHighscore();
+        info.timestamp = modificationTime(path);
+        info.size = file.size();
+        info.checksum = crc32(file.view());
+        m_slots[name] = std::move(info);
+        return true;
+    }
+
+    bool SaveSlots::rebuildIndex()
+    {
+        m_slots.clear();
+
+        std::error_code ec;
+        for (const auto &entry : std::filesystem::directory_iterator(m_directory, ec))
+        {
+            const std::filesystem::path &path = entry.path();
+            if (!entry.is_regular_file(ec) || path.extension() != SLOT_EXTENSION)
+                continue;
+
+            std::string name = path.stem().string();
+            if (isValidName(name))
+                refreshSlot(name);
+        }
+        if (ec)
+        {
+            DATACOE_LOG_ERROR("SaveSlots::rebuildIndex() Could not list directory: " << m_directory << " (" << ec.message() << ")");
+            return false;
+        }
+
+        if (!writeIndex())
+            return false;
+        removePendingMarker();
+        return true;
+    }
+
+    bool SaveSlots::save(const std::string &name, const GameData &gamedata)
+    {
+        if (!isValidName(name))
+        {
+            DATACOE_LOG_ERROR("SaveSlots::save() Invalid slot name: '" << name << "'");
+            return false;
+        }
+
+        ChunkStore chunks(slotPath(name), m_options);
+        chunks.plan(gamedata);
+        std::optional<std::string> fileData = DataReaderWriter::encode(gamedata, m_options, &chunks);
+        if (!fileData || !writePendingMarker(name))
+            return false;
+
+        std::string error;
+        if (!FileWriter::writeAtomically(slotPath(name), *fileData, m_options.durability, error))
+        {
+            DATACOE_LOG_ERROR("SaveSlots::save() " << error);
+            removePendingMarker();
+            return false;
+        }
+        chunks.finish();
+
+        // The metadata comes from the bytes just written, nothing is read back
+        // The timestamp is the file's, like rebuildIndex() records, so a rebuilt index lists the same time
+        SlotInfo info;
+        info.name = name;
+        info.nickname = gamedata.getNickname();
+        info.highscore = gamedata.getHighscore();
+        info.timestamp = modificationTime(slotPath(name));
+        info.size = fileData->size();
+        info.checksum = crc32(*fileData);
+        m_slots[name] = std::move(info);
+
+        // Leave the marker behind if the index could not be written, open() repairs it
+        if (!writeIndex())
+            return false;
+        removePendingMarker();
+        return true;
+    }
+
+    std::optional<GameData> SaveSlots::load(const std::string &name) const
+    {
+        if (!isValidName(name))
+        {
+            DATACOE_LOG_ERROR("SaveSlots::load() Invalid slot name: '" << name << "'");
+            return std::nullopt;
+        }
+
+        ReadOptions options;
+        options.decryption = m_options.encryption;
+        return DataReaderWriter::readData(slotPath(name), options);
+    }
+
+    bool SaveSlots::remove(const std::string &name)
+    {
+        if (!isValidName(name) || m_slots.find(name) == m_slots.end())
+            return false;
+
+        if (!writePendingMarker(name))
+            return false;
+
+        std::error_code ec;
+        std::filesystem::remove(slotPath(name), ec);
+        if (ec)
+        {
+            DATACOE_LOG_ERROR("SaveSlots::remove() Could not remove slot '" << name << "' (" << ec.message() << ")");
+            removePendingMarker();
+            return false;
+        }
+        ChunkStore::remove(slotPath(name));
+
+        m_slots.erase(name);
+        if (!writeIndex())
+            return false;
+        removePendingMarker();
+        return true;
+    }
+
+    std::vector<SlotInfo> SaveSlots::list() const
+    {
+        std::vector<SlotInfo> slots;
+        slots.reserve(m_slots.size());
+        for (const auto &[name, info] : m_slots)
+            slots.push_back(info);
+        return slots;
+    }
+
+    std::optional<SlotInfo> SaveSlots::info(const std::string &name) const
+    {
+        auto it = m_slots.find(name);
+        if (it == m_slots.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    std::size_t SaveSlots::size() const
+    {
+        return m_slots.size();
+    }
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "save_worker.hpp"
+#include "datacoe/logger.hpp"
+#include <exception>
+#include <utility>
+
+namespace datacoe
+{
+    SaveWorker::~SaveWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wakeup.notify_one();
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    std::future<bool> SaveWorker::submit(Request request)
+    {
+        std::promise<bool> promise;
+        std::future<bool> future = promise.get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_pending)
+                m_coalesced++;
+            m_pending = std::move(request);
+            m_waiters.push_back(std::move(promise));
+
+            if (!m_thread.joinable())
+                m_thread = std::thread(&SaveWorker::run, this);
+        }
+        m_wakeup.notify_one();
+        return future;
+    }
+
+    void SaveWorker::waitUntilIdle()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this]()
+                    { return !m_pending && !m_writing; });
+    }
+
+    bool SaveWorker::isIdle()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_pending && !m_writing;
+    }
+
+    std::size_t SaveWorker::coalescedCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_coalesced;
+    }
+
+    void SaveWorker::run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_wakeup.wait(lock, [this]()
+                          { return m_pending || m_stopping; });
+            if (!m_pending)
+                break; // stopping with nothing left to write
+
+            Request request = std::move(*m_pending);
+            m_pending.reset();
+            std::vector<std::promise<bool>> waiters = std::move(m_waiters);
+            m_waiters.clear();
+            m_writing = true;
+            lock.unlock();
+
+            if (waiters.size() > 1)
+                DATACOE_LOG_DEBUG("SaveWorker::run() Coalesced " << waiters.size() << " saves into one write of " << request.filename);
+
+            bool result = false;
+            try
+            {
+                result = request.write ? request.write(request)
+                                       : DataReaderWriter::writeData(*request.gamedata, request.filename, request.options);
+                if (request.onComplete)
+                    request.onComplete(result);
+            }
+            catch (const std::exception &e)
+            {
+                DATACOE_LOG_ERROR("SaveWorker::run() " << e.what());
+                result = false;
+            }
+
+            for (std::promise<bool> &waiter : waiters)
+                waiter.set_value(result);
+
+            lock.lock();
+            m_writing = false;
+            if (!m_pending)
+                m_idle.notify_all();
+        }
+    }
+} // namespace datacoe
\ No newline at end of file
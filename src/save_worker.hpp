@@ -0,0 +1,67 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "datacoe/data_reader_writer.hpp"
+#include "datacoe/game_data.hpp"
+
+namespace datacoe
+{
+    // Internal helper, not part of the public API
+    // Single background thread that writes saves handed over by DataManager::saveGameAsync().
+    // Only the newest request is kept while a write is in flight, so a burst of saves
+    // collapses into one write of the latest state and every caller gets that write's result
+    class SaveWorker
+    {
+    public:
+        struct Request
+        {
+            std::shared_ptr<const GameData> gamedata; // immutable snapshot shared with readers, never copied
+            std::string filename;
+            WriteOptions options;
+            std::function<void(bool)> onComplete; // runs on the worker thread before the futures are set
+            std::function<bool(const Request &)> write; // replaces DataReaderWriter::writeData() when set
+        };
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        std::condition_variable m_idle;
+        std::optional<Request> m_pending;
+        std::vector<std::promise<bool>> m_waiters;
+        std::size_t m_coalesced = 0;
+        bool m_writing = false;
+        bool m_stopping = false;
+        std::thread m_thread; // started by the first submit()
+
+        void run();
+
+    public:
+        SaveWorker() = default;
+        // writes whatever is still pending before returning, so no requested save is lost
+        ~SaveWorker();
+
+        SaveWorker(const SaveWorker &) = delete;
+        SaveWorker &operator=(const SaveWorker &) = delete;
+
+        // replaces any request that has not started writing yet
+        std::future<bool> submit(Request request);
+
+        // blocks until every submitted request has been written
+        void waitUntilIdle();
+
+        // true when nothing is pending or being written, without waiting
+        bool isIdle();
+
+        // number of requests that were replaced by a newer one before being written
+        std::size_t coalescedCount();
+    };
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "datacoe/schema_migrations.hpp"
+#include "datacoe/logger.hpp"
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace datacoe
+{
+    namespace
+    {
+        // The steps that ship with the game, keyed by the version they upgrade from
+        // Users add a step here whenever they change the fields of GameData and bump GameData::SCHEMA_VERSION
+        std::map<int, MigrationStep> builtInSteps()
+        {
+            return {
+                // 0 -> 1: the schema version key was introduced, the fields stayed the same
+                {0, [](json &) {}},
+            };
+        }
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::map<int, MigrationStep> steps = builtInSteps();
+        };
+
+        Registry &registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+    } // namespace
+
+    void SchemaMigrations::add(int fromVersion, MigrationStep step)
+    {
+        Registry &steps = registry();
+        std::lock_guard<std::mutex> lock(steps.mutex);
+        steps.steps[fromVersion] = std::move(step);
+    }
+
+    void SchemaMigrations::reset()
+    {
+        Registry &steps = registry();
+        std::lock_guard<std::mutex> lock(steps.mutex);
+        steps.steps = builtInSteps();
+    }
+
+    void SchemaMigrations::migrate(json &save, int version, int targetVersion)
+    {
+        for (int from = version; from < targetVersion; from++)
+        {
+            // copied out, so parallel loads don't wait on each other's steps
+            MigrationStep step;
+            {
+                Registry &steps = registry();
+                std::lock_guard<std::mutex> lock(steps.mutex);
+                auto it = steps.steps.find(from);
+                if (it != steps.steps.end())
+                    step = it->second;
+            }
+            if (!step)
+                throw std::runtime_error("No migration from schema version " + std::to_string(from) + " to " + std::to_string(from + 1));
+            step(save);
+        }
+
+        save[GameData::SCHEMA_VERSION_KEY] = targetVersion;
+        DATACOE_LOG_INFO("SchemaMigrations::migrate() Migrated a save from schema version " << version << " to " << targetVersion);
+    }
+} // namespace datacoe
\ No newline at end of file
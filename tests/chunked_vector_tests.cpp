@@ -0,0 +1,397 @@
+#include <gtest/gtest.h>
+#include <datacoe/chunked_vector.hpp>
+#include <datacoe/field_reflection.hpp>
+#include "chunk_store.hpp"
+#include "file_writer.hpp"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace datacoe
+{
+    namespace
+    {
+        // GameData ships without a ChunkedVector field, the chunk packs are tested through this type
+        struct Collection
+        {
+            std::string owner;
+            ChunkedVector<std::string> achievements;
+
+            static constexpr auto fields()
+            {
+                return std::make_tuple(field("owner", &Collection::owner),
+                                       field("achievements", &Collection::achievements));
+            }
+        };
+
+        bool operator==(const Collection &a, const Collection &b) { return reflection::equal(a, b); }
+    } // namespace
+
+    class ChunkedVectorTest : public ::testing::Test
+    {
+    protected:
+        std::string m_directory;
+        std::string m_testFilename;
+
+        void SetUp() override
+        {
+            m_directory = "test_chunked_vector";
+            std::error_code ec;
+            std::filesystem::remove_all(m_directory, ec);
+            std::filesystem::create_directories(m_directory);
+            m_testFilename = (std::filesystem::path(m_directory) / "save.json").string();
+        }
+
+        void TearDown() override
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(m_directory, ec);
+        }
+
+        std::string packOf(const std::string &save, int parity) const { return save + ".chunks" + std::to_string(parity); }
+
+        static std::vector<std::string> achievements(std::size_t count, const std::string &prefix = "achievement-")
+        {
+            std::vector<std::string> values;
+            for (std::size_t i = 0; i < count; i++)
+                values.push_back(prefix + std::to_string(i));
+            return values;
+        }
+
+        static Collection collector(std::size_t count)
+        {
+            Collection collection;
+            collection.owner = "Collector";
+            collection.achievements = achievements(count);
+            return collection;
+        }
+
+        // The steps DataReaderWriter::writeData() takes for GameData: the chunks go to the pack before the save
+        // that references them, and the pack the save no longer uses is deleted after it
+        static bool save(const Collection &collection, const std::string &filename, bool encryption)
+        {
+            WriteOptions options;
+            options.encryption = encryption;
+            ChunkStore chunks(filename, options);
+            chunks.plan(collection);
+            json j = reflection::toJson(collection, &chunks);
+            std::string error;
+            if (!chunks.flush(error) || !FileWriter::writeAtomically(filename, j.dump(), options.durability, error))
+                return false;
+            chunks.finish();
+            return true;
+        }
+
+        // The steps of DataReaderWriter::readData(): the save holds the manifests, the chunks stay in the pack until accessed
+        static std::optional<Collection> load(const std::string &filename)
+        {
+            std::ifstream file(filename, std::ios::binary);
+            if (!file)
+                return std::nullopt;
+            Collection collection = reflection::fromJson<Collection>(json::parse(file));
+            std::string error;
+            if (!ChunkStore::attach(collection, filename, error))
+                return std::nullopt;
+            return collection;
+        }
+    };
+
+    TEST_F(ChunkedVectorTest, CopiesShareUnchangedChunks)
+    {
+        ChunkedVector<int, 4> values({0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+        ASSERT_EQ(values.size(), 10u);
+        ASSERT_EQ(values.chunkCount(), 3u);
+        ASSERT_EQ(values[9], 9);
+        ASSERT_THROW(values.at(10), std::out_of_range);
+
+        // A change copies only the chunk it touches
+        ChunkedVector<int, 4> copy = values;
+        copy.set(5, 50);
+        copy.update(6, [](int &value)
+                    { value *= 10; });
+        ASSERT_EQ(copy.chunks()[0], values.chunks()[0]);
+        ASSERT_NE(copy.chunks()[1], values.chunks()[1]);
+        ASSERT_EQ(copy.chunks()[2], values.chunks()[2]);
+        ASSERT_EQ(values[5], 5);
+        ASSERT_EQ(copy[5], 50);
+        ASSERT_EQ(copy[6], 60);
+        ASSERT_NE(copy, values);
+
+        // Growing and shrinking across chunk boundaries
+        for (int i = 10; i < 13; i++)
+            copy.push_back(i);
+        ASSERT_EQ(copy.chunkCount(), 4u);
+        for (int i = 0; i < 4; i++)
+            copy.pop_back();
+        ASSERT_EQ(copy.chunkCount(), 3u);
+        ASSERT_EQ(copy.back(), 8);
+        ASSERT_EQ(values.size(), 10u);
+
+        // Saves without a file hold a plain array
+        json j = copy;
+        ASSERT_EQ(j, json({0, 1, 2, 3, 4, 50, 60, 7, 8}));
+        ASSERT_EQ(j.get<decltype(copy)>(), copy);
+        copy.clear();
+        ASSERT_TRUE(copy.empty());
+    }
+
+    TEST_F(ChunkedVectorTest, DiffListsChangedElements)
+    {
+        ChunkedVector<int, 4> from({0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+        ChunkedVector<int, 4> to = from;
+        to.set(1, 10);
+        to.push_back(10);
+
+        json patch = json::array();
+        to.diff(from, "/values", patch);
+        ASSERT_EQ(patch, json::parse(R"([{"op":"replace","path":"/values/1","value":10},{"op":"add","path":"/values/-","value":10}])"));
+
+        json document = {{"values", from}};
+        ASSERT_EQ(document.patch(patch)["values"], json(to));
+
+        // Rewriting most of the elements is one replace
+        ChunkedVector<int, 4> rewritten(std::vector<int>(10, -1));
+        patch = json::array();
+        rewritten.diff(from, "/values", patch);
+        ASSERT_EQ(patch.size(), 1u);
+        ASSERT_EQ(patch[0]["path"], "/values");
+    }
+
+    TEST_F(ChunkedVectorTest, LoadsChunksOnFirstAccess)
+    {
+        Collection collection = collector(3000);
+        ASSERT_TRUE(save(collection, m_testFilename, true));
+        ASSERT_TRUE(std::filesystem::exists(packOf(m_testFilename, 1)));
+        ASSERT_LT(std::filesystem::file_size(m_testFilename), 512u) << "The save should only hold the chunk manifest";
+
+        std::optional<Collection> loaded = load(m_testFilename);
+        ASSERT_TRUE(loaded.has_value());
+        const ChunkedVector<std::string> &loadedAchievements = loaded->achievements;
+        ASSERT_EQ(loadedAchievements.size(), 3000u);
+        ASSERT_EQ(loadedAchievements.loadedChunkCount(), 0u);
+
+        ASSERT_EQ(loadedAchievements[2500], "achievement-2500");
+        ASSERT_EQ(loadedAchievements.loadedChunkCount(), 1u);
+
+        // Chunks stored in the same blob are equal without loading them
+        std::optional<Collection> again = load(m_testFilename);
+        ASSERT_EQ(*again, *loaded);
+        ASSERT_EQ(again->achievements.loadedChunkCount(), 0u);
+        ASSERT_EQ(*loaded, collection);
+    }
+
+    TEST_F(ChunkedVectorTest, HashReadsNoChunks)
+    {
+        Collection collection = collector(3000);
+        ASSERT_TRUE(save(collection, m_testFilename, true));
+
+        // A loaded save hashes like the data it was written from, the digests come from the manifest
+        std::optional<Collection> loaded = load(m_testFilename);
+        ASSERT_TRUE(loaded.has_value());
+        ASSERT_EQ(reflection::hash(*loaded), reflection::hash(collection));
+        ASSERT_EQ(loaded->achievements.loadedChunkCount(), 0u);
+
+        // Equal elements built another way hash the same, a changed element doesn't
+        std::hash<ChunkedVector<std::string>> hash;
+        ChunkedVector<std::string> rebuilt(achievements(3000));
+        ASSERT_EQ(hash(rebuilt), hash(loaded->achievements));
+        rebuilt.set(2999, "changed");
+        ASSERT_NE(hash(rebuilt), hash(loaded->achievements));
+        ASSERT_EQ(loaded->achievements.loadedChunkCount(), 0u);
+    }
+
+    TEST_F(ChunkedVectorTest, SavesOnlyChangedChunks)
+    {
+        for (bool encryption : {false, true})
+        {
+            std::filesystem::remove(m_testFilename);
+            std::filesystem::remove(packOf(m_testFilename, 0));
+            std::filesystem::remove(packOf(m_testFilename, 1));
+
+            ASSERT_TRUE(save(collector(3000), m_testFilename, encryption));
+            auto packSize = std::filesystem::file_size(packOf(m_testFilename, 1));
+
+            // An unchanged save appends nothing
+            Collection collection = load(m_testFilename).value();
+            ASSERT_TRUE(save(collection, m_testFilename, encryption));
+            ASSERT_EQ(std::filesystem::file_size(packOf(m_testFilename, 1)), packSize);
+
+            // One changed element appends its chunk
+            collection.achievements.set(1500, "changed");
+            ASSERT_TRUE(save(collection, m_testFilename, encryption));
+            auto grown = std::filesystem::file_size(packOf(m_testFilename, 1)) - packSize;
+            ASSERT_GT(grown, 0u);
+            ASSERT_LT(grown, packSize / 2) << "Only the changed chunk should be appended";
+
+            std::optional<Collection> loaded = load(m_testFilename);
+            ASSERT_TRUE(loaded.has_value());
+            ASSERT_EQ(loaded->achievements[1500], "changed");
+            ASSERT_EQ(loaded->achievements.loadedChunkCount(), 1u);
+            ASSERT_EQ(loaded->achievements.toVector(), collection.achievements.toVector());
+        }
+    }
+
+    TEST_F(ChunkedVectorTest, RewritesPackFullOfGarbage)
+    {
+        Collection collection = collector(3000);
+        ASSERT_TRUE(save(collection, m_testFilename, false));
+
+        // Every save rewrites every chunk, until the garbage outweighs the live chunks and the next generation is written
+        bool rewritten = false;
+        for (int round = 0; round < 20 && !rewritten; round++)
+        {
+            collection.achievements = achievements(3000, "round-" + std::to_string(round) + "-");
+            ASSERT_TRUE(save(collection, m_testFilename, false));
+            rewritten = std::filesystem::exists(packOf(m_testFilename, 0));
+        }
+        ASSERT_TRUE(rewritten);
+        ASSERT_FALSE(std::filesystem::exists(packOf(m_testFilename, 1))) << "The old generation should be deleted";
+
+        std::optional<Collection> loaded = load(m_testFilename);
+        ASSERT_TRUE(loaded.has_value());
+        ASSERT_EQ(*loaded, collection);
+
+        // Emptying the field deletes the pack
+        collection.achievements.clear();
+        ASSERT_TRUE(save(collection, m_testFilename, false));
+        ASSERT_FALSE(std::filesystem::exists(packOf(m_testFilename, 0)));
+        ASSERT_EQ(load(m_testFilename).value(), collection);
+    }
+
+    TEST_F(ChunkedVectorTest, OldPackIsDeletedWhileCopiesLive)
+    {
+        ASSERT_TRUE(save(collector(3000), m_testFilename, false));
+
+        // A copy of the loaded save stays alive across the saves below, with one of its chunks loaded
+        const Collection kept = load(m_testFilename).value();
+        ASSERT_EQ(kept.achievements[0], "achievement-0");
+
+        // Two saves that each write a new generation, no pack is held open so the old one is deleted every time
+        Collection collection = kept;
+        int round = 0;
+        for (int parity : {0, 1})
+        {
+            while (!std::filesystem::exists(packOf(m_testFilename, parity)) && round < 40)
+            {
+                collection.achievements = achievements(3000, "round-" + std::to_string(round++) + "-");
+                ASSERT_TRUE(save(collection, m_testFilename, false));
+            }
+            ASSERT_TRUE(std::filesystem::exists(packOf(m_testFilename, parity)));
+            ASSERT_FALSE(std::filesystem::exists(packOf(m_testFilename, 1 - parity))) << "Only the newest generation should remain";
+        }
+
+        // The copy keeps what it loaded, the chunks it never read went with their generation
+        ASSERT_EQ(kept.achievements[0], "achievement-0");
+        ASSERT_THROW(kept.achievements[2999], std::runtime_error);
+        ASSERT_EQ(load(m_testFilename).value(), collection);
+    }
+
+    TEST_F(ChunkedVectorTest, ConcurrentSavesOfOneFile)
+    {
+        // Saves of the same file wait for each other, however its path is spelled
+        std::string spellings[] = {m_testFilename, (std::filesystem::path(m_directory) / "." / "save.json").string()};
+        std::vector<std::thread> savers;
+        std::atomic<int> failures{0};
+        for (int t = 0; t < 4; t++)
+            savers.emplace_back([&, t]()
+                                {
+                for (int round = 0; round < 5; round++)
+                {
+                    Collection collection;
+                    collection.owner = "Saver" + std::to_string(t);
+                    collection.achievements = achievements(2000, std::to_string(t) + "-" + std::to_string(round) + "-");
+                    if (!save(collection, spellings[(t + round) % 2], false))
+                        failures++;
+                } });
+        for (std::thread &saver : savers)
+            saver.join();
+        ASSERT_EQ(failures, 0);
+
+        // The last save is complete, with every chunk in the pack it references
+        std::optional<Collection> loaded = load(m_testFilename);
+        ASSERT_TRUE(loaded.has_value());
+        ASSERT_EQ(loaded->achievements.size(), 2000u);
+        ASSERT_NO_THROW(loaded->achievements.toVector());
+    }
+
+    TEST_F(ChunkedVectorTest, DamagedPacksAreDetected)
+    {
+        ASSERT_TRUE(save(collector(3000), m_testFilename, false));
+        {
+            std::fstream pack(packOf(m_testFilename, 1), std::ios::binary | std::ios::in | std::ios::out);
+            pack.seekp(-8, std::ios::end);
+            pack.put('#');
+        }
+
+        // The damage is found when the chunk is read
+        std::optional<Collection> loaded = load(m_testFilename);
+        ASSERT_TRUE(loaded.has_value());
+        ASSERT_EQ(loaded->achievements[0], "achievement-0");
+        ASSERT_THROW(loaded->achievements[2999], std::runtime_error);
+
+        // A missing pack makes the save unreadable
+        std::filesystem::remove(packOf(m_testFilename, 1));
+        ASSERT_FALSE(load(m_testFilename).has_value());
+
+        // So do manifests that don't add up
+        ChunkedVector<int, 4> values;
+        ASSERT_ANY_THROW(json::parse(R"({"pack":1,"size":5,"chunks":[[24,10,0,4,0,0]]})").get_to(values));
+        ASSERT_ANY_THROW(json::parse(R"({"pack":1,"size":5,"chunks":[[24,10,0,1,0,0],[34,10,0,4,0,0]]})").get_to(values));
+        ASSERT_ANY_THROW(json::parse(R"({"pack":1,"size":1})").get_to(values));
+        ASSERT_ANY_THROW(json::parse(R"("values")").get_to(values));
+
+        // As does reading a chunk of a save that was never attached to its packs
+        values = json::parse(R"({"pack":1,"size":4,"chunks":[[24,10,0,4,0,0]]})").get<ChunkedVector<int, 4>>();
+        ASSERT_THROW(values[0], std::runtime_error);
+    }
+
+    TEST_F(ChunkedVectorTest, ReplayedChangesKeepStoredChunks)
+    {
+        ASSERT_TRUE(save(collector(3000), m_testFilename, false));
+        Collection loaded = load(m_testFilename).value();
+        auto packSize = std::filesystem::file_size(packOf(m_testFilename, 1));
+
+        // What a journal record holds: the one new element, not the whole field
+        Collection changed = loaded;
+        changed.achievements.push_back("journaled");
+        json patch = reflection::diff(loaded, changed);
+        ASSERT_EQ(patch.size(), 1u);
+        ASSERT_LT(patch.dump().size(), 128u) << "The record should hold only the new element";
+
+        // Replaying it rebuilds the field from json, the chunks it left alone go back to their blobs
+        json state = reflection::toJson(loaded);
+        state.patch_inplace(patch);
+        Collection replayed = reflection::fromJson<Collection>(std::move(state));
+        reflection::adoptUnchangedChunks(replayed, loaded);
+        ASSERT_EQ(replayed, changed);
+        ASSERT_EQ(replayed.achievements.chunks()[0], loaded.achievements.chunks()[0]);
+
+        // So saving the replayed state appends only the chunk that grew
+        ASSERT_TRUE(save(replayed, m_testFilename, false));
+        ASSERT_LT(std::filesystem::file_size(packOf(m_testFilename, 1)) - packSize, packSize / 2);
+        Collection reloaded = load(m_testFilename).value();
+        ASSERT_EQ(reloaded.achievements.size(), 3001u);
+        ASSERT_EQ(reloaded.achievements.back(), "journaled");
+        ASSERT_EQ(reloaded.achievements[0], "achievement-0");
+    }
+
+    TEST_F(ChunkedVectorTest, SavesKeepTheirOwnPacks)
+    {
+        std::string first = (std::filesystem::path(m_directory) / "first.sav").string();
+        std::string second = (std::filesystem::path(m_directory) / "second.sav").string();
+
+        Collection collection = collector(2000);
+        ASSERT_TRUE(save(collection, first, false));
+        ASSERT_TRUE(save(load(first).value(), second, false));
+        ASSERT_TRUE(std::filesystem::exists(packOf(second, 1)));
+
+        ChunkStore::remove(first);
+        ASSERT_FALSE(std::filesystem::exists(packOf(first, 1)));
+        ASSERT_EQ(load(second).value(), collection);
+    }
+} // namespace datacoe
\ No newline at end of file
@@ -1,10 +1,15 @@
 #include <gtest/gtest.h>
 #include <datacoe/data_manager.hpp>
 #include <datacoe/data_reader_writer.hpp>
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
+#include <fstream>
 #include <thread>
 #include <chrono>
 #include <iostream>
+#include <limits>
+#include <vector>
 
 namespace datacoe
 {
@@ -28,6 +33,13 @@ namespace datacoe
             {
                 // Ignore errors if file doesn't exist
             }
+            std::error_code ec;
+            std::filesystem::remove(journalFilename(), ec);
+        }
+
+        std::string journalFilename() const
+        {
+            return m_testFilename + ".journal";
         }
 
         void TearDown() override
@@ -52,6 +64,20 @@ namespace datacoe
                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 }
             }
+            std::error_code ec;
+            std::filesystem::remove(journalFilename(), ec);
+        }
+
+        std::string readTestFile() const
+        {
+            std::ifstream file(m_testFilename, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        void writeTestFile(const std::string &contents) const
+        {
+            std::ofstream file(m_testFilename, std::ios::binary);
+            file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
         }
     };
 
@@ -477,4 +503,822 @@ namespace datacoe
             FAIL() << "Unexpected exception: " << e.what();
         }
     }
+
+    TEST_F(DataManagerTest, MmapThreshold)
+    {
+        try
+        {
+            DataManager dm;
+            ASSERT_EQ(dm.getMmapThreshold(), ReadOptions::DEFAULT_MMAP_THRESHOLD);
+
+            dm.init(m_testFilename);
+            dm.setGamedata(GameData("MappedLoad", 900));
+            ASSERT_TRUE(dm.saveGame());
+
+            // Force every load through the memory mapping
+            DataManager dm2;
+            dm2.setMmapThreshold(1);
+            ASSERT_EQ(dm2.getMmapThreshold(), 1u);
+            ASSERT_TRUE(dm2.init(m_testFilename)) << "init() should load the save through a memory mapping";
+            ASSERT_EQ(dm2.getGamedata().getNickname(), "MappedLoad");
+            ASSERT_EQ(dm2.getGamedata().getHighscore(), 900);
+            ASSERT_TRUE(dm2.isEncrypted());
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, SerializationFormat)
+    {
+        try
+        {
+            DataManager dm;
+            ASSERT_EQ(dm.getSerializationFormat(), SerializationFormat::Json);
+
+            dm.init(m_testFilename, false);
+            dm.setSerializationFormat(SerializationFormat::MessagePack);
+            ASSERT_EQ(dm.getSerializationFormat(), SerializationFormat::MessagePack);
+            dm.setGamedata(GameData("PackedPlayer", 321));
+            ASSERT_TRUE(dm.saveGame());
+
+            // A manager set to another format still loads the save, the format comes from the file
+            DataManager dm2;
+            dm2.setSerializationFormat(SerializationFormat::Bson);
+            ASSERT_TRUE(dm2.init(m_testFilename, false));
+            ASSERT_EQ(dm2.getGamedata().getNickname(), "PackedPlayer");
+            ASSERT_EQ(dm2.getGamedata().getHighscore(), 321);
+            ASSERT_FALSE(dm2.isEncrypted());
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, SaveGameAsync)
+    {
+        try
+        {
+            DataManager dm;
+            dm.init(m_testFilename);
+            dm.setGamedata(GameData("AsyncPlayer", 10));
+
+            std::future<bool> saved = dm.saveGameAsync();
+            // The snapshot was taken at the call, this change is not part of it
+            dm.setGamedata(GameData("AsyncPlayer", 20));
+            ASSERT_TRUE(saved.get());
+            ASSERT_TRUE(dm.isEncrypted());
+
+            std::optional<GameData> onDisk = DataReaderWriter::readData(m_testFilename);
+            ASSERT_TRUE(onDisk.has_value());
+            ASSERT_EQ(onDisk.value().getHighscore(), 10);
+
+            // A burst of saves collapses into fewer writes, every caller still gets a result
+            dm.setDurability(Durability::Full);
+            std::vector<std::future<bool>> results;
+            for (int i = 0; i < 100; i++)
+            {
+                dm.setGamedata(GameData("AsyncPlayer", 100 + i));
+                results.push_back(dm.saveGameAsync());
+            }
+            for (std::future<bool> &result : results)
+                ASSERT_TRUE(result.get());
+            ASSERT_GT(dm.getCoalescedSaveCount(), 0u) << "Saves made during a write should have been coalesced";
+
+            // The newest state is the one on disk
+            onDisk = DataReaderWriter::readData(m_testFilename);
+            ASSERT_TRUE(onDisk.has_value());
+            ASSERT_EQ(onDisk.value().getHighscore(), 199);
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, SaveGameAsyncFinishesBeforeDestruction)
+    {
+        try
+        {
+            {
+                DataManager dm;
+                dm.init(m_testFilename);
+                dm.setGamedata(GameData("LastWords", 77));
+                dm.saveGameAsync(); // result ignored on purpose
+            }
+
+            // The destructor waited for the pending write
+            DataManager dm2;
+            ASSERT_TRUE(dm2.init(m_testFilename));
+            ASSERT_EQ(dm2.getGamedata().getNickname(), "LastWords");
+            ASSERT_EQ(dm2.getGamedata().getHighscore(), 77);
+
+            // A synchronous save right after an async one is the one that sticks
+            dm2.setGamedata(GameData("LastWords", 78));
+            dm2.saveGameAsync();
+            dm2.setGamedata(GameData("LastWords", 79));
+            ASSERT_TRUE(dm2.saveGame());
+            ASSERT_TRUE(dm2.loadGame());
+            ASSERT_EQ(dm2.getGamedata().getHighscore(), 79);
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, SaveGameWhileBackgroundWriteRuns)
+    {
+        try
+        {
+            DataManager dm;
+            dm.init(m_testFilename);
+            dm.setDurability(Durability::Full);
+            dm.setGamedata(GameData("Waiter", 0));
+
+            // saveGame() waits for the background writer without holding the state lock,
+            // so the setters on this thread keep going while the other thread saves
+            std::atomic<bool> saverFailed{false};
+            std::thread saver([&dm, &saverFailed]()
+                              {
+                for (int i = 0; i < 20; i++)
+                {
+                    dm.saveGameAsync();
+                    if (!dm.saveGame())
+                        saverFailed = true;
+                } });
+            for (int i = 1; i <= 200; i++)
+                dm.updateGamedata([i](GameData &gd)
+                                  { gd.setHighscore(i); });
+            saver.join();
+            ASSERT_FALSE(saverFailed);
+
+            // The last synchronous save after all the changes is the one on disk
+            ASSERT_TRUE(dm.saveGame());
+            std::optional<GameData> onDisk = DataReaderWriter::readData(m_testFilename);
+            ASSERT_TRUE(onDisk.has_value());
+            ASSERT_EQ(onDisk.value().getHighscore(), 200);
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, SkipUnchangedSaves)
+    {
+        try
+        {
+            DataManager dm;
+            dm.init(m_testFilename);
+            ASSERT_TRUE(dm.isDirty()) << "A new game has not been saved yet";
+
+            dm.setGamedata(GameData("DirtyTracker", 10));
+            ASSERT_TRUE(dm.saveGame());
+            ASSERT_FALSE(dm.isDirty());
+            auto firstWrite = std::filesystem::last_write_time(m_testFilename);
+
+            // Nothing changed, no write
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ASSERT_TRUE(dm.saveGame());
+            ASSERT_TRUE(dm.saveGameAsync().get());
+            dm.setGamedata(GameData("DirtyTracker", 10)); // same data is not a change
+            ASSERT_TRUE(dm.saveGame());
+            ASSERT_EQ(dm.getSkippedSaveCount(), 3u);
+            ASSERT_EQ(std::filesystem::last_write_time(m_testFilename), firstWrite);
+
+            // Changes are written
+            dm.setGamedata(GameData("DirtyTracker", 11));
+            ASSERT_TRUE(dm.isDirty());
+            ASSERT_TRUE(dm.saveGameAsync().get());
+            ASSERT_FALSE(dm.isDirty());
+
+            // Switching the encryption rewrites the file in the new format
+            dm.setEncryption(false);
+            ASSERT_TRUE(dm.isDirty());
+            ASSERT_TRUE(dm.saveGame());
+            ASSERT_FALSE(DataReaderWriter::isFileEncrypted(m_testFilename));
+
+            // A deleted save is written again
+            std::filesystem::remove(m_testFilename);
+            ASSERT_TRUE(dm.saveGame());
+            ASSERT_TRUE(std::filesystem::exists(m_testFilename));
+
+            // Loading leaves the manager clean
+            DataManager dm2;
+            ASSERT_TRUE(dm2.init(m_testFilename, false));
+            ASSERT_FALSE(dm2.isDirty());
+            dm2.markDirty();
+            ASSERT_TRUE(dm2.isDirty());
+            ASSERT_EQ(dm.getSkippedSaveCount(), 3u);
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, LoadedSaveStoredDifferently)
+    {
+        try
+        {
+            // An encrypted save loaded without encryption is rewritten as plain text
+            ASSERT_TRUE(DataReaderWriter::writeData(GameData("Layout", 1), m_testFilename, true));
+            {
+                DataManager dm;
+                ASSERT_TRUE(dm.init(m_testFilename, false));
+                ASSERT_TRUE(dm.isDirty());
+                ASSERT_TRUE(dm.saveGame());
+                ASSERT_EQ(dm.getSkippedSaveCount(), 0u);
+                ASSERT_FALSE(DataReaderWriter::isFileEncrypted(m_testFilename));
+            }
+
+            // and a plain text save loaded with encryption is encrypted
+            {
+                DataManager dm;
+                ASSERT_TRUE(dm.init(m_testFilename, true));
+                ASSERT_TRUE(dm.isDirty());
+                ASSERT_TRUE(dm.saveGame());
+                ASSERT_TRUE(DataReaderWriter::isFileEncrypted(m_testFilename));
+            }
+
+            // A save stored the way the manager stores it stays clean
+            {
+                DataManager dm;
+                ASSERT_TRUE(dm.init(m_testFilename, true));
+                ASSERT_FALSE(dm.isDirty());
+            }
+
+            // Legacy AES-CBC and Base64 saves are upgraded to AES-GCM containers by the next save
+            const std::string cbcContainer(
+                "\x44\x43\x4f\x45\x01\x01\x00\x00\x50\x00\x00\x00\x00\x00\x00\x00"
+                "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                "\x26\x2d\xa1\xed\xff\x48\x2a\x46\x74\xf5\x30\xd4\xbd\x80\xe2\x37"
+                "\xc7\x83\x14\x95\x47\x92\xea\xbd\x2d\x9f\xd5\xab\xa6\xef\xb8\x7b"
+                "\x51\xf3\x1e\x6f\xaa\xa5\x79\x8c\xfd\x75\x0a\x8f\x56\xd6\x1c\x56"
+                "\xeb\x07\xc8\xce\x1d\x41\x48\xc8\xa5\xc1\xe3\xe4\x00\x94\x26\xa5",
+                96);
+            const std::string base64Save = "DATACOE_ENCRYPTED"
+                                            "Dx4tPEtaaXiHlqW0w9Lh8BLyq6RaC45glmnntFCUk8+QE/vFtaY0wcIzdbCo0rdd53lFinfK\n"
+                                            "k+7WKLRuwAzx74oucmva+68CO9EfKvBTldaSXxFrjUFxl0fj1ymtFtleKaeTdMSJFiA8fbgu\n"
+                                            "axKubRigyaow3GDLogrXOn4Aa8I=\n";
+            for (const std::string &legacy : {cbcContainer, base64Save})
+            {
+                writeTestFile(legacy);
+                DataManager dm;
+                ASSERT_TRUE(dm.init(m_testFilename));
+                ASSERT_TRUE(dm.isDirty());
+                ASSERT_TRUE(dm.saveGame());
+                std::string contents = readTestFile();
+                ASSERT_EQ(contents.substr(0, 4), "DCOE");
+                ASSERT_EQ(contents[5], '\x02') << "AES-GCM cipher id";
+
+                DataManager reloaded;
+                ASSERT_TRUE(reloaded.init(m_testFilename));
+                ASSERT_FALSE(reloaded.isDirty());
+            }
+
+            // A save in another format is rewritten in the manager's format
+            WriteOptions cbor;
+            cbor.format = SerializationFormat::Cbor;
+            ASSERT_TRUE(DataReaderWriter::writeData(GameData("Layout", 2), m_testFilename, cbor));
+            {
+                DataManager dm;
+                ASSERT_TRUE(dm.init(m_testFilename));
+                ASSERT_TRUE(dm.isDirty());
+
+                DataManager sameFormat;
+                sameFormat.setSerializationFormat(SerializationFormat::Cbor);
+                ASSERT_TRUE(sameFormat.init(m_testFilename));
+                ASSERT_FALSE(sameFormat.isDirty());
+            }
+
+            // and a save compressed differently with the manager's compression
+            WriteOptions compressed;
+            compressed.compression = Compression::High;
+            ASSERT_TRUE(DataReaderWriter::writeData(GameData(std::string(4096, 'c'), 3), m_testFilename, compressed));
+            {
+                DataManager dm;
+                ASSERT_TRUE(dm.init(m_testFilename));
+                ASSERT_TRUE(dm.isDirty());
+                ASSERT_TRUE(dm.saveGame());
+                SaveInfo info;
+                ReadOptions readOptions;
+                ASSERT_TRUE(DataReaderWriter::decode(readTestFile(), readOptions, &info).has_value());
+                ASSERT_EQ(info.compression, Compression::None);
+
+                DataManager sameCompression;
+                sameCompression.setCompression(Compression::High);
+                ASSERT_TRUE(sameCompression.init(m_testFilename));
+                ASSERT_TRUE(sameCompression.isDirty());
+                ASSERT_TRUE(sameCompression.saveGame());
+                DataManager reloaded;
+                reloaded.setCompression(Compression::High);
+                ASSERT_TRUE(reloaded.init(m_testFilename));
+                ASSERT_FALSE(reloaded.isDirty());
+            }
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, AutoSaveTick)
+    {
+        try
+        {
+            DataManager dm;
+            dm.init(m_testFilename);
+            ASSERT_FALSE(dm.isAutoSaveEnabled());
+
+            AutoSaveOptions options;
+            options.interval = std::chrono::milliseconds(0);
+            options.debounce = std::chrono::milliseconds(200);
+            options.maxStaleness = std::chrono::seconds(60);
+            dm.enableAutoSave(options);
+            ASSERT_TRUE(dm.isAutoSaveEnabled());
+
+            // Nothing changed, nothing to save
+            ASSERT_FALSE(dm.tick());
+
+            // A burst of changes is written once, after it settled
+            for (int i = 0; i < 5; i++)
+            {
+                dm.setGamedata(GameData("AutoSaver", i));
+                ASSERT_FALSE(dm.tick()) << "Saved while changes were still coming in";
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            ASSERT_TRUE(dm.tick());
+            ASSERT_FALSE(dm.tick()) << "The same changes were saved twice";
+            ASSERT_EQ(dm.getAutoSaveCount(), 1u);
+
+            dm.waitForPendingSaves();
+            std::optional<GameData> onDisk = DataReaderWriter::readData(m_testFilename);
+            ASSERT_TRUE(onDisk.has_value());
+            ASSERT_EQ(onDisk.value().getHighscore(), 4);
+
+            // Changes that never settle are still written once they are too old
+            options.debounce = std::chrono::seconds(60);
+            options.maxStaleness = std::chrono::milliseconds(100);
+            dm.enableAutoSave(options);
+            bool saved = false;
+            for (int i = 0; i < 100 && !saved; i++)
+            {
+                dm.setGamedata(GameData("AutoSaver", 100 + i));
+                saved = dm.tick();
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            ASSERT_TRUE(saved) << "Max staleness did not force a save";
+
+            dm.disableAutoSave();
+            dm.setGamedata(GameData("AutoSaver", 1000));
+            std::this_thread::sleep_for(std::chrono::milliseconds(150));
+            ASSERT_FALSE(dm.tick());
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, AutoSaveBackgroundTimer)
+    {
+        try
+        {
+            DataManager dm;
+            dm.init(m_testFilename);
+
+            AutoSaveOptions options;
+            options.interval = std::chrono::milliseconds(0);
+            options.debounce = std::chrono::milliseconds(50);
+            options.backgroundTimer = true;
+            dm.enableAutoSave(options);
+
+            dm.setGamedata(GameData("TimerSaver", 42));
+            for (int i = 0; i < 100 && dm.getAutoSaveCount() == 0; i++)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            ASSERT_EQ(dm.getAutoSaveCount(), 1u) << "The timer did not save the change";
+
+            dm.waitForPendingSaves();
+            ASSERT_FALSE(dm.isDirty());
+            std::optional<GameData> onDisk = DataReaderWriter::readData(m_testFilename);
+            ASSERT_TRUE(onDisk.has_value());
+            ASSERT_EQ(onDisk.value().getNickname(), "TimerSaver");
+            ASSERT_EQ(onDisk.value().getHighscore(), 42);
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, ConcurrentSnapshotReads)
+    {
+        try
+        {
+            DataManager dm;
+            dm.init(m_testFilename);
+            dm.setGamedata(GameData("Player0", 0));
+
+            std::shared_ptr<const GameData> initial = dm.getSnapshot();
+            ASSERT_EQ(initial->getNickname(), "Player0");
+
+            // A writer thread publishes new data, saves and reloads while readers check
+            // that every snapshot they see is a consistent nickname/highscore pair
+            std::atomic<bool> done{false};
+            std::atomic<int> inconsistent{0};
+            std::atomic<long long> reads{0};
+            std::vector<std::thread> readers;
+            for (int r = 0; r < 3; r++)
+            {
+                readers.emplace_back([&]()
+                                     {
+                    while (!done)
+                    {
+                        std::shared_ptr<const GameData> snapshot = dm.getSnapshot();
+                        if (snapshot->getNickname() != "Player" + std::to_string(snapshot->getHighscore()))
+                            inconsistent++;
+                        reads++;
+                    } });
+            }
+
+            std::thread writer([&]()
+                               {
+                for (int i = 1; i <= 200; i++)
+                {
+                    dm.setGamedata(GameData("Player" + std::to_string(i), i));
+                    if (i % 20 == 0)
+                        dm.saveGame();
+                    if (i % 50 == 0)
+                        dm.loadGame();
+                    if (i % 10 == 0)
+                        dm.saveGameAsync();
+                }
+                done = true; });
+
+            writer.join();
+            for (std::thread &reader : readers)
+                reader.join();
+
+            ASSERT_EQ(inconsistent, 0) << "A reader saw a half-written GameData";
+            ASSERT_GT(reads, 0);
+            ASSERT_EQ(dm.getSnapshot()->getHighscore(), 200);
+
+            // Old snapshots stay valid and unchanged
+            ASSERT_EQ(initial->getNickname(), "Player0");
+            ASSERT_EQ(initial->getHighscore(), 0);
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, JournalSaves)
+    {
+        try
+        {
+            JournalOptions options;
+            options.maxRecords = 1000;
+            options.maxSizeRatio = 1000.0;
+
+            DataManager dm;
+            dm.enableJournal(options);
+            ASSERT_TRUE(dm.isJournalEnabled());
+            dm.init(m_testFilename);
+            dm.setGamedata(GameData(std::string(4096, 'J'), 0));
+
+            // The first save writes the whole file and starts an empty journal for it
+            ASSERT_TRUE(dm.saveGame());
+            ASSERT_TRUE(std::filesystem::exists(journalFilename()));
+            auto fileSize = std::filesystem::file_size(m_testFilename);
+            auto fileWrite = std::filesystem::last_write_time(m_testFilename);
+
+            // Later saves only append their changes
+            for (int score = 1; score <= 10; score++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                dm.setGamedata(GameData(std::string(4096, 'J'), score));
+                ASSERT_TRUE(dm.saveGame());
+            }
+            dm.setGamedata(GameData(std::string(4096, 'J'), 11));
+            ASSERT_TRUE(dm.saveGameAsync().get());
+            ASSERT_EQ(std::filesystem::file_size(m_testFilename), fileSize);
+            ASSERT_EQ(std::filesystem::last_write_time(m_testFilename), fileWrite);
+            ASSERT_LT(std::filesystem::file_size(journalFilename()), fileSize) << "11 one-field records should be smaller than one snapshot";
+            ASSERT_EQ(dm.getCompactionCount(), 0u);
+
+            // Loading replays the journal, with or without journal mode
+            DataManager dm2;
+            ASSERT_TRUE(dm2.init(m_testFilename));
+            ASSERT_EQ(dm2.getGamedata().getHighscore(), 11);
+            ASSERT_FALSE(dm2.isDirty());
+
+            // Leaving journal mode folds the journal into the file
+            dm.disableJournal();
+            ASSERT_TRUE(dm.saveGame());
+            ASSERT_FALSE(std::filesystem::exists(journalFilename()));
+            ASSERT_NE(std::filesystem::last_write_time(m_testFilename), fileWrite);
+
+            DataManager dm3;
+            ASSERT_TRUE(dm3.init(m_testFilename));
+            ASSERT_EQ(dm3.getGamedata().getHighscore(), 11);
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, JournalCompaction)
+    {
+        try
+        {
+            JournalOptions options;
+            options.maxRecords = 4;
+            options.maxSizeRatio = 1000.0;
+
+            DataManager dm;
+            dm.enableJournal(options);
+            dm.init(m_testFilename);
+            dm.setGamedata(GameData("Compactor", 0));
+            ASSERT_TRUE(dm.saveGame());
+            auto emptyJournalSize = std::filesystem::file_size(journalFilename());
+
+            for (int score = 1; score <= 4; score++)
+            {
+                dm.setGamedata(GameData("Compactor", score));
+                ASSERT_TRUE(dm.saveGame());
+            }
+
+            // The fourth record triggered a rewrite of the file on the background writer
+            dm.waitForPendingSaves();
+            ASSERT_EQ(dm.getCompactionCount(), 1u);
+            ASSERT_EQ(std::filesystem::file_size(journalFilename()), emptyJournalSize);
+            std::optional<GameData> file = DataReaderWriter::readData(m_testFilename);
+            ASSERT_TRUE(file.has_value());
+            ASSERT_EQ(file.value().getHighscore(), 4);
+
+            // The size limit works the same way, a nickname change as big as the file reaches it at once
+            options.maxRecords = 1000;
+            options.maxSizeRatio = 0.5;
+            dm.enableJournal(options);
+            dm.setGamedata(GameData(std::string(256, 'C'), 5));
+            ASSERT_TRUE(dm.saveGame());
+            dm.waitForPendingSaves();
+            ASSERT_EQ(dm.getCompactionCount(), 2u);
+
+            DataManager dm2;
+            ASSERT_TRUE(dm2.init(m_testFilename));
+            ASSERT_EQ(dm2.getGamedata().getNickname(), std::string(256, 'C'));
+            ASSERT_EQ(dm2.getGamedata().getHighscore(), 5);
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, JournalRecovery)
+    {
+        try
+        {
+            // Limits out of reach, so no background compaction runs while the files are modified below
+            JournalOptions options;
+            options.maxRecords = 1000;
+            options.maxSizeRatio = 1000.0;
+
+            DataManager dm;
+            dm.enableJournal(options);
+            dm.init(m_testFilename);
+            for (int score = 1; score <= 3; score++)
+            {
+                dm.setGamedata(GameData("Survivor", score));
+                ASSERT_TRUE(dm.saveGame());
+            }
+            auto journalSize = std::filesystem::file_size(journalFilename());
+
+            // A crash in the middle of an append leaves a torn record, the complete ones still load
+            {
+                std::ofstream journal(journalFilename(), std::ios::binary | std::ios::app);
+                journal << std::string("\x40\x00\x00\x00torn", 8);
+            }
+            DataManager dm2;
+            dm2.enableJournal(options);
+            ASSERT_TRUE(dm2.init(m_testFilename));
+            ASSERT_EQ(dm2.getGamedata().getHighscore(), 3);
+
+            // The next append replaces the torn record
+            dm2.setGamedata(GameData("Survivor", 4));
+            ASSERT_TRUE(dm2.saveGame());
+            ASSERT_GT(std::filesystem::file_size(journalFilename()), journalSize);
+            DataManager dm3;
+            ASSERT_TRUE(dm3.init(m_testFilename));
+            ASSERT_EQ(dm3.getGamedata().getHighscore(), 4);
+
+            // A tampered record fails authentication, replay stops before it
+            std::string data;
+            {
+                std::ifstream in(journalFilename(), std::ios::binary);
+                data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            }
+            data[data.size() - 1] ^= 0x01;
+            {
+                std::ofstream out(journalFilename(), std::ios::binary | std::ios::trunc);
+                out << data;
+            }
+            DataManager dm4;
+            ASSERT_TRUE(dm4.init(m_testFilename));
+            ASSERT_EQ(dm4.getGamedata().getHighscore(), 3);
+
+            // A journal that belongs to an older version of the file is ignored
+            dm3.setGamedata(GameData("Survivor", 50));
+            ASSERT_TRUE(dm3.saveGame()); // journal mode off, writes the file and deletes the journal
+            ASSERT_FALSE(std::filesystem::exists(journalFilename()));
+            {
+                std::ofstream out(journalFilename(), std::ios::binary | std::ios::trunc);
+                out << data;
+            }
+            DataManager dm5;
+            ASSERT_TRUE(dm5.init(m_testFilename));
+            ASSERT_EQ(dm5.getGamedata().getHighscore(), 50);
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, InitAsync)
+    {
+        try
+        {
+            ASSERT_TRUE(DataReaderWriter::writeData(GameData("AsyncLoader", 321), m_testFilename));
+
+            DataManager dm;
+            LoadTask task = dm.initAsync(m_testFilename);
+            ASSERT_TRUE(task.get());
+            ASSERT_TRUE(task.isReady());
+            ASSERT_FALSE(task.isCancelled());
+            ASSERT_FLOAT_EQ(task.getProgress(), 1.0f);
+            ASSERT_EQ(dm.getGamedata().getNickname(), "AsyncLoader");
+            ASSERT_EQ(dm.getSnapshot()->getHighscore(), 321);
+            ASSERT_FALSE(dm.isDirty());
+
+            // A missing save starts a new game, like init()
+            std::filesystem::remove(m_testFilename);
+            DataManager fresh;
+            LoadTask missing = fresh.initAsync(m_testFilename);
+            ASSERT_FALSE(missing.get());
+            ASSERT_FALSE(missing.isCancelled());
+            ASSERT_TRUE(fresh.getGamedata().getNickname().empty());
+            ASSERT_TRUE(fresh.isDirty());
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, LoadGameAsyncProgressAndCancel)
+    {
+        try
+        {
+            // Several read chunks, so the load reports progress on the way
+            const std::string bigNickname(8 * 1024 * 1024, 'P');
+            ASSERT_TRUE(DataReaderWriter::writeData(GameData(bigNickname, 7), m_testFilename));
+
+            DataManager dm;
+            dm.setMmapThreshold(std::numeric_limits<std::size_t>::max());
+
+            LoadTask task = dm.initAsync(m_testFilename);
+            std::vector<float> progress;
+            while (!task.isReady())
+            {
+                progress.push_back(task.getProgress());
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            ASSERT_TRUE(task.get());
+            ASSERT_TRUE(std::is_sorted(progress.begin(), progress.end()));
+            ASSERT_FLOAT_EQ(task.getProgress(), 1.0f);
+            ASSERT_EQ(dm.getGamedata().getHighscore(), 7);
+
+            // A cancelled load leaves the current GameData alone, one that finished first is applied as usual
+            dm.setGamedata(GameData("Current", 2));
+            LoadTask cancelled = dm.loadGameAsync();
+            cancelled.cancel();
+            bool loaded = cancelled.get();
+            ASSERT_NE(loaded, cancelled.isCancelled());
+            if (cancelled.isCancelled())
+            {
+                ASSERT_EQ(dm.getGamedata().getNickname(), "Current");
+                ASSERT_EQ(dm.getGamedata().getHighscore(), 2);
+            }
+            else
+            {
+                ASSERT_EQ(dm.getGamedata().getHighscore(), 7);
+            }
+
+            // Starting a load cancels the one still running, the newest one wins
+            dm.setGamedata(GameData("Current", 3));
+            LoadTask first = dm.loadGameAsync();
+            LoadTask second = dm.loadGameAsync();
+            ASSERT_TRUE(first.isReady());
+            ASSERT_TRUE(second.get());
+            ASSERT_EQ(dm.getGamedata().getHighscore(), 7);
+
+            // Destroying the manager stops a load in flight
+            {
+                DataManager shortLived;
+                LoadTask abandoned = shortLived.initAsync(m_testFilename);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, ChangesDuringAsyncLoad)
+    {
+        try
+        {
+            const std::string bigNickname(8 * 1024 * 1024, 'P');
+            ASSERT_TRUE(DataReaderWriter::writeData(GameData(bigNickname, 7), m_testFilename));
+
+            DataManager dm;
+            dm.setMmapThreshold(std::numeric_limits<std::size_t>::max());
+
+            // GameData set while the load is in flight wins, the load result is dropped
+            LoadTask task = dm.initAsync(m_testFilename);
+            dm.setGamedata(GameData("Chosen", 5));
+            ASSERT_FALSE(task.get());
+            ASSERT_TRUE(task.isCancelled());
+            ASSERT_EQ(dm.getGamedata().getNickname(), "Chosen");
+            ASSERT_EQ(dm.getSnapshot()->getHighscore(), 5);
+            ASSERT_TRUE(dm.isDirty());
+            dm.tick();
+            ASSERT_EQ(dm.getGamedata().getHighscore(), 5);
+
+            // A finished load waits for the owning thread, tick() applies it
+            LoadTask waiting = dm.loadGameAsync();
+            while (waiting.getProgress() < 1.0f)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ASSERT_EQ(dm.getGamedata().getHighscore(), 5);
+            dm.tick();
+            ASSERT_EQ(dm.getGamedata().getHighscore(), 7);
+            ASSERT_TRUE(waiting.isReady());
+            ASSERT_TRUE(waiting.get());
+            ASSERT_TRUE(waiting.getFuture().get());
+
+            // loadGame() and init() replace a load that was not applied yet
+            dm.setGamedata(GameData("Other", 1));
+            LoadTask replaced = dm.loadGameAsync();
+            ASSERT_TRUE(dm.loadGame());
+            ASSERT_TRUE(replaced.isReady());
+            ASSERT_TRUE(replaced.isCancelled());
+            ASSERT_EQ(dm.getGamedata().getHighscore(), 7);
+
+            LoadTask beforeInit = dm.loadGameAsync();
+            ASSERT_TRUE(dm.init(m_testFilename));
+            ASSERT_TRUE(beforeInit.isCancelled());
+            ASSERT_FALSE(beforeInit.get());
+            ASSERT_EQ(dm.getGamedata().getHighscore(), 7);
+        }
+        catch (const std::exception &e)
+        {
+            FAIL() << "Unexpected exception: " << e.what();
+        }
+    }
+
+    TEST_F(DataManagerTest, Compression)
+    {
+        DataManager dm;
+        ASSERT_EQ(dm.getCompression(), Compression::None);
+
+        dm.init(m_testFilename);
+        dm.setGamedata(GameData(std::string(10000, 'c'), 99));
+        ASSERT_TRUE(dm.saveGame());
+        auto uncompressedSize = std::filesystem::file_size(m_testFilename);
+
+        // Changing the codec rewrites the save even though GameData did not change
+        dm.setCompression(Compression::Fast);
+        ASSERT_EQ(dm.getCompression(), Compression::Fast);
+        ASSERT_TRUE(dm.isDirty());
+        ASSERT_TRUE(dm.saveGame());
+        ASSERT_EQ(dm.getSkippedSaveCount(), 0u);
+        ASSERT_LT(std::filesystem::file_size(m_testFilename) * 10, uncompressedSize);
+
+        // A manager set to another codec still loads the save, the codec comes from the file
+        DataManager dm2;
+        dm2.setCompression(Compression::High);
+        ASSERT_TRUE(dm2.init(m_testFilename));
+        ASSERT_EQ(dm2.getGamedata().getNickname(), std::string(10000, 'c'));
+        ASSERT_EQ(dm2.getGamedata().getHighscore(), 99);
+        ASSERT_TRUE(dm2.isEncrypted());
+    }
 } // namespace datacoe
\ No newline at end of file
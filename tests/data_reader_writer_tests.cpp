@@ -302,4 +302,547 @@ namespace datacoe
             FAIL() << "Unexpected exception: " << e.what();
         }
     }
+
+    TEST_F(DataReaderWriterTest, ReadDataReportsFileFormat)
+    {
+        std::string unencryptedFilename = m_testFilename + ".unencrypted";
+
+        GameData testData("FormatReport", 700);
+        ASSERT_TRUE(DataReaderWriter::writeData(testData, m_testFilename, true));
+        ASSERT_TRUE(DataReaderWriter::writeData(testData, unencryptedFilename, false));
+
+        // The detected format is reported from the same read, without a separate isFileEncrypted() call
+        bool fileEncrypted = false;
+        std::optional<GameData> loadedEncrypted = DataReaderWriter::readData(m_testFilename, true, &fileEncrypted);
+        ASSERT_TRUE(loadedEncrypted.has_value());
+        ASSERT_TRUE(fileEncrypted) << "Encrypted file should be reported as encrypted";
+
+        std::optional<GameData> loadedUnencrypted = DataReaderWriter::readData(unencryptedFilename, true, &fileEncrypted);
+        ASSERT_TRUE(loadedUnencrypted.has_value());
+        ASSERT_FALSE(fileEncrypted) << "Unencrypted file should be reported as unencrypted";
+        ASSERT_EQ(loadedUnencrypted.value().getNickname(), "FormatReport");
+
+        fileEncrypted = true;
+        ASSERT_FALSE(DataReaderWriter::readData("non_existent_file.json", true, &fileEncrypted).has_value());
+        ASSERT_FALSE(fileEncrypted) << "Missing file should be reported as unencrypted";
+
+        std::filesystem::remove(unencryptedFilename);
+    }
+
+    TEST_F(DataReaderWriterTest, ReadLargeFileMemoryMapped)
+    {
+        std::string unencryptedFilename = m_testFilename + ".unencrypted";
+
+        // Large enough to be above the default mmap threshold
+        std::string largeNickname(2 * ReadOptions::DEFAULT_MMAP_THRESHOLD, 'M');
+        GameData largeData(largeNickname, 800);
+
+        ASSERT_TRUE(DataReaderWriter::writeData(largeData, m_testFilename, true));
+        ASSERT_TRUE(DataReaderWriter::writeData(largeData, unencryptedFilename, false));
+
+        ReadOptions mapped;
+        mapped.mmapThreshold = 1; // map every non-empty file
+
+        ReadOptions buffered;
+        buffered.mmapThreshold = static_cast<std::size_t>(-1); // never map
+
+        for (const std::string &filename : {m_testFilename, unencryptedFilename})
+        {
+            std::optional<GameData> fromDefault = DataReaderWriter::readData(filename);
+            std::optional<GameData> fromMapping = DataReaderWriter::readData(filename, mapped);
+            std::optional<GameData> fromBuffer = DataReaderWriter::readData(filename, buffered);
+
+            ASSERT_TRUE(fromDefault.has_value()) << "Failed to read " << filename << " with the default threshold";
+            ASSERT_TRUE(fromMapping.has_value()) << "Failed to read " << filename << " through a memory mapping";
+            ASSERT_TRUE(fromBuffer.has_value()) << "Failed to read " << filename << " through the buffered path";
+
+            ASSERT_EQ(fromMapping.value().getNickname(), largeNickname);
+            ASSERT_EQ(fromMapping.value().getHighscore(), 800);
+            ASSERT_EQ(fromBuffer.value().getNickname(), fromMapping.value().getNickname());
+            ASSERT_EQ(fromDefault.value().getNickname(), fromMapping.value().getNickname());
+        }
+
+        // Small files go through the same code path when mapping is forced
+        GameData smallData("SmallMapped", 801);
+        ASSERT_TRUE(DataReaderWriter::writeData(smallData, m_testFilename, true));
+        std::optional<GameData> smallMapped = DataReaderWriter::readData(m_testFilename, mapped);
+        ASSERT_TRUE(smallMapped.has_value());
+        ASSERT_EQ(smallMapped.value().getNickname(), "SmallMapped");
+
+        // Corrupted data is still rejected when mapped
+        {
+            std::ofstream file(m_testFilename, std::ios::trunc);
+            file << "DATACOE_ENCRYPTED" << std::string(4096, '!');
+        }
+        ASSERT_FALSE(DataReaderWriter::readData(m_testFilename, mapped).has_value());
+
+        std::filesystem::remove(unencryptedFilename);
+    }
+
+    TEST_F(DataReaderWriterTest, WriteWithDurabilityLevels)
+    {
+        for (Durability durability : {Durability::None, Durability::Data, Durability::Full})
+        {
+            for (bool encryption : {true, false})
+            {
+                GameData gd("DurabilityTest", static_cast<int>(durability) * 10 + (encryption ? 1 : 0));
+
+                WriteOptions options;
+                options.encryption = encryption;
+                options.durability = durability;
+                ASSERT_TRUE(DataReaderWriter::writeData(gd, m_testFilename, options))
+                    << "Failed to write with durability level " << static_cast<int>(durability);
+
+                std::optional<GameData> loadedData = DataReaderWriter::readData(m_testFilename);
+                ASSERT_TRUE(loadedData.has_value());
+                ASSERT_EQ(loadedData.value().getNickname(), "DurabilityTest");
+                ASSERT_EQ(loadedData.value().getHighscore(), gd.getHighscore());
+                ASSERT_EQ(DataReaderWriter::isFileEncrypted(m_testFilename), encryption);
+            }
+        }
+
+        // The temporary files used for the atomic replace must not be left behind
+        for (const auto &entry : std::filesystem::directory_iterator("."))
+        {
+            std::string name = entry.path().filename().string();
+            ASSERT_NE(name.rfind(m_testFilename + ".tmp", 0), 0u) << "Leftover temporary file: " << name;
+        }
+    }
+
+    TEST_F(DataReaderWriterTest, ReadLegacyLineBrokenFormat)
+    {
+        // Encrypted save as written by v0.1.0: Base64 with a line break every 72 characters
+        {
+            std::ofstream file(m_testFilename, std::ios::binary);
+            file << "DATACOE_ENCRYPTED"
+                 << "Dx4tPEtaaXiHlqW0w9Lh8BLyq6RaC45glmnntFCUk8+QE/vFtaY0wcIzdbCo0rdd53lFinfK\n"
+                 << "k+7WKLRuwAzx74oucmva+68CO9EfKvBTldaSXxFrjUFxl0fj1ymtFtleKaeTdMSJFiA8fbgu\n"
+                 << "axKubRigyaow3GDLogrXOn4Aa8I=\n";
+        }
+
+        ASSERT_TRUE(DataReaderWriter::isFileEncrypted(m_testFilename));
+
+        std::optional<GameData> loadedData = DataReaderWriter::readData(m_testFilename);
+        ASSERT_TRUE(loadedData.has_value()) << "Failed to read a save written by an older version";
+        ASSERT_EQ(loadedData.value().getNickname(), "LegacyPlayerWithAVeryLongNicknameSoTheBase64OutputWrapsOverMultipleLines");
+        ASSERT_EQ(loadedData.value().getHighscore(), 4242);
+    }
+
+    TEST_F(DataReaderWriterTest, EncryptedPayloadSizes)
+    {
+        // Exercise empty, partial and multiple AES blocks of data
+        for (size_t length = 0; length <= 40; length++)
+        {
+            GameData gd(std::string(length, 'p'), static_cast<int>(length));
+            ASSERT_TRUE(DataReaderWriter::writeData(gd, m_testFilename, true));
+
+            std::optional<GameData> loadedData = DataReaderWriter::readData(m_testFilename);
+            ASSERT_TRUE(loadedData.has_value()) << "Failed to round-trip a nickname of " << length << " bytes";
+            ASSERT_EQ(loadedData.value().getNickname(), std::string(length, 'p'));
+            ASSERT_EQ(loadedData.value().getHighscore(), static_cast<int>(length));
+        }
+    }
+
+    TEST_F(DataReaderWriterTest, BinaryContainerFormat)
+    {
+        GameData gd("ContainerTest", 900);
+        std::string json = gd.toJson().dump();
+        ASSERT_TRUE(DataReaderWriter::writeData(gd, m_testFilename, true));
+
+        std::string contents;
+        {
+            std::ifstream file(m_testFilename, std::ios::binary);
+            contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        // magic | version | cipher | flags | payload length, then raw IV, ciphertext and tag without Base64
+        constexpr size_t headerSize = 16;
+        constexpr size_t ivSize = 12;
+        constexpr size_t tagSize = 16;
+        ASSERT_GE(contents.size(), headerSize);
+        ASSERT_EQ(contents.substr(0, 4), "DCOE");
+        ASSERT_EQ(static_cast<int>(contents[4]), 1) << "Unexpected container version";
+        ASSERT_EQ(static_cast<int>(contents[5]), 2) << "New saves should use AES-GCM";
+
+        uint64_t payloadLength = 0;
+        for (size_t i = 0; i < 8; i++)
+            payloadLength |= static_cast<uint64_t>(static_cast<unsigned char>(contents[8 + i])) << (8 * i);
+        ASSERT_EQ(payloadLength, contents.size() - headerSize);
+
+        // The summary block comes first: its length, then the summary fields sealed on their own
+        constexpr size_t summaryLengthSize = 4;
+        std::string summary = nlohmann::json{{"nickname", "ContainerTest"}, {"highscore", 900}, {GameData::SCHEMA_VERSION_KEY, GameData::SCHEMA_VERSION}}.dump();
+        ASSERT_EQ(static_cast<int>(contents[6]), 0x40) << "New saves should have a summary block";
+        ASSERT_EQ(static_cast<size_t>(static_cast<unsigned char>(contents[headerSize])), ivSize + summary.size() + tagSize);
+
+        // GCM is a stream mode, the ciphertext is exactly as long as the JSON
+        ASSERT_EQ(contents.size(), headerSize + summaryLengthSize + ivSize + summary.size() + tagSize + ivSize + json.size() + tagSize)
+            << "Payload should be the raw IV, ciphertext and tag";
+
+        // Truncated payload is rejected
+        {
+            std::ofstream file(m_testFilename, std::ios::binary | std::ios::trunc);
+            file.write(contents.data(), static_cast<std::streamsize>(contents.size() - tagSize));
+        }
+        ASSERT_TRUE(DataReaderWriter::isFileEncrypted(m_testFilename));
+        ASSERT_FALSE(DataReaderWriter::readData(m_testFilename).has_value()) << "Truncated container should not load";
+
+        // Unknown future version is rejected
+        std::string futureVersion = contents;
+        futureVersion[4] = static_cast<char>(99);
+        {
+            std::ofstream file(m_testFilename, std::ios::binary | std::ios::trunc);
+            file.write(futureVersion.data(), static_cast<std::streamsize>(futureVersion.size()));
+        }
+        ASSERT_FALSE(DataReaderWriter::readData(m_testFilename).has_value()) << "Unknown container version should not load";
+
+        // The original file still loads
+        {
+            std::ofstream file(m_testFilename, std::ios::binary | std::ios::trunc);
+            file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        }
+        std::optional<GameData> loadedData = DataReaderWriter::readData(m_testFilename);
+        ASSERT_TRUE(loadedData.has_value());
+        ASSERT_EQ(loadedData.value().getNickname(), "ContainerTest");
+        ASSERT_EQ(loadedData.value().getHighscore(), 900);
+    }
+
+    TEST_F(DataReaderWriterTest, TamperedSaveRejected)
+    {
+        GameData gd("HonestPlayer", 100);
+        ASSERT_TRUE(DataReaderWriter::writeData(gd, m_testFilename, true));
+
+        std::string contents;
+        {
+            std::ifstream file(m_testFilename, std::ios::binary);
+            contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        // Flipping any single bit, in the header flags, the IV, the ciphertext or the tag, must be detected
+        // (bytes 0-5 and 8-15 are magic, version, cipher and length, which are rejected by the format checks)
+        for (size_t position : {size_t(6), size_t(16), size_t(30), contents.size() / 2, contents.size() - 1})
+        {
+            std::string tampered = contents;
+            tampered[position] = static_cast<char>(tampered[position] ^ 0x01);
+            {
+                std::ofstream file(m_testFilename, std::ios::binary | std::ios::trunc);
+                file.write(tampered.data(), static_cast<std::streamsize>(tampered.size()));
+            }
+            ASSERT_FALSE(DataReaderWriter::readData(m_testFilename).has_value()) << "Tampered byte " << position << " was not detected";
+        }
+
+        // Report only, the result depends on the machine running the tests
+        std::cout << "AES-GCM hardware acceleration: " << (DataReaderWriter::isHardwareAccelerated() ? "yes" : "no") << std::endl;
+    }
+
+    TEST_F(DataReaderWriterTest, ReadAesCbcContainer)
+    {
+        // Binary container with AES-CBC as written before AES-GCM became the default
+        const std::string cbcContainer(
+            "\x44\x43\x4f\x45\x01\x01\x00\x00\x50\x00\x00\x00\x00\x00\x00\x00"
+            "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+            "\x26\x2d\xa1\xed\xff\x48\x2a\x46\x74\xf5\x30\xd4\xbd\x80\xe2\x37"
+            "\xc7\x83\x14\x95\x47\x92\xea\xbd\x2d\x9f\xd5\xab\xa6\xef\xb8\x7b"
+            "\x51\xf3\x1e\x6f\xaa\xa5\x79\x8c\xfd\x75\x0a\x8f\x56\xd6\x1c\x56"
+            "\xeb\x07\xc8\xce\x1d\x41\x48\xc8\xa5\xc1\xe3\xe4\x00\x94\x26\xa5",
+            96);
+        {
+            std::ofstream file(m_testFilename, std::ios::binary);
+            file.write(cbcContainer.data(), static_cast<std::streamsize>(cbcContainer.size()));
+        }
+
+        ASSERT_TRUE(DataReaderWriter::isFileEncrypted(m_testFilename));
+
+        std::optional<GameData> loadedData = DataReaderWriter::readData(m_testFilename);
+        ASSERT_TRUE(loadedData.has_value()) << "Failed to read an AES-CBC save";
+        ASSERT_EQ(loadedData.value().getNickname(), "CbcContainerPlayer");
+        ASSERT_EQ(loadedData.value().getHighscore(), 1717);
+    }
+
+    TEST_F(DataReaderWriterTest, SerializationFormats)
+    {
+        const std::pair<SerializationFormat, const char *> formats[] = {
+            {SerializationFormat::Json, "JSON"},
+            {SerializationFormat::Cbor, "CBOR"},
+            {SerializationFormat::MessagePack, "MessagePack"},
+            {SerializationFormat::Bson, "BSON"}};
+
+        for (const auto &[format, name] : formats)
+        {
+            for (bool encryption : {false, true})
+            {
+                GameData gd(std::string("Format") + name, 77 + static_cast<int>(format));
+                WriteOptions options;
+                options.encryption = encryption;
+                options.format = format;
+                ASSERT_TRUE(DataReaderWriter::writeData(gd, m_testFilename, options)) << name;
+
+                std::string contents;
+                {
+                    std::ifstream file(m_testFilename, std::ios::binary);
+                    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                }
+
+                if (!encryption && format == SerializationFormat::Json)
+                {
+                    // Unencrypted JSON stays a readable text file
+                    ASSERT_EQ(contents.front(), '{');
+                }
+                else
+                {
+                    // Everything else is a container recording the format in the flags
+                    ASSERT_EQ(contents.substr(0, 4), "DCOE") << name;
+                    ASSERT_EQ(static_cast<int>(contents[6]) & 0x0F, static_cast<int>(format)) << name;
+                }
+                ASSERT_EQ(DataReaderWriter::isFileEncrypted(m_testFilename), encryption) << name;
+
+                // The reader detects the format on its own
+                bool fileEncrypted = !encryption;
+                std::optional<GameData> loadedData = DataReaderWriter::readData(m_testFilename, encryption, &fileEncrypted);
+                ASSERT_TRUE(loadedData.has_value()) << "Failed to read " << name << (encryption ? " (encrypted)" : "");
+                ASSERT_EQ(loadedData.value().getNickname(), gd.getNickname());
+                ASSERT_EQ(loadedData.value().getHighscore(), gd.getHighscore());
+                ASSERT_EQ(fileEncrypted, encryption);
+            }
+        }
+
+        // Unknown format in an unencrypted container is rejected
+        GameData gd("UnknownFormat", 1);
+        WriteOptions options;
+        options.encryption = false;
+        options.format = SerializationFormat::Cbor;
+        ASSERT_TRUE(DataReaderWriter::writeData(gd, m_testFilename, options));
+        std::string contents;
+        {
+            std::ifstream file(m_testFilename, std::ios::binary);
+            contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        contents[6] = static_cast<char>(9);
+        {
+            std::ofstream file(m_testFilename, std::ios::binary | std::ios::trunc);
+            file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        }
+        ASSERT_FALSE(DataReaderWriter::readData(m_testFilename, false).has_value());
+    }
+
+    TEST_F(DataReaderWriterTest, WriteManyAndReadMany)
+    {
+        const std::string directory = "test_batch_saves";
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+        std::filesystem::create_directories(directory);
+
+        constexpr int count = 64;
+        std::vector<std::pair<GameData, std::string>> jobs;
+        std::vector<std::string> filenames;
+        for (int i = 0; i < count; i++)
+        {
+            std::string filename = directory + "/player" + std::to_string(i) + ".data";
+            jobs.emplace_back(GameData("Player" + std::to_string(i), i * 10), filename);
+            filenames.push_back(filename);
+        }
+        // An unwritable target fails on its own without affecting the others
+        jobs.emplace_back(GameData("Nowhere", 1), directory + "/missing_dir/player.data");
+        filenames.push_back(directory + "/missing_dir/player.data");
+
+        for (std::size_t threads : {1u, 4u, 0u})
+        {
+            std::vector<bool> written = DataReaderWriter::writeMany(jobs, WriteOptions(), threads);
+            ASSERT_EQ(written.size(), jobs.size());
+            for (int i = 0; i < count; i++)
+                ASSERT_TRUE(written[i]) << "threads=" << threads << " item " << i;
+            ASSERT_FALSE(written.back());
+
+            std::vector<std::optional<GameData>> loaded = DataReaderWriter::readMany(filenames, ReadOptions(), threads);
+            ASSERT_EQ(loaded.size(), filenames.size());
+            for (int i = 0; i < count; i++)
+            {
+                ASSERT_TRUE(loaded[i].has_value()) << "threads=" << threads << " item " << i;
+                ASSERT_EQ(loaded[i].value(), jobs[i].first);
+            }
+            ASSERT_FALSE(loaded.back().has_value());
+        }
+
+        ASSERT_TRUE(DataReaderWriter::writeMany({}).empty());
+        ASSERT_TRUE(DataReaderWriter::readMany({}).empty());
+
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    TEST_F(DataReaderWriterTest, CompressedSaves)
+    {
+        // Repetitive data, like real saves full of repeated keys and similar values
+        GameData gd(std::string(4000, 'a') + std::string(4000, 'b') + "end", 4242);
+        std::uintmax_t uncompressedSize = 0;
+
+        const std::pair<Compression, const char *> codecs[] = {
+            {Compression::None, "None"},
+            {Compression::Fast, "Fast"},
+            {Compression::High, "High"}};
+
+        for (const auto &[compression, name] : codecs)
+        {
+            for (SerializationFormat format : {SerializationFormat::Json, SerializationFormat::MessagePack})
+            {
+                for (bool encryption : {false, true})
+                {
+                    WriteOptions options;
+                    options.encryption = encryption;
+                    options.format = format;
+                    options.compression = compression;
+                    ASSERT_TRUE(DataReaderWriter::writeData(gd, m_testFilename, options)) << name;
+
+                    std::string contents;
+                    {
+                        std::ifstream file(m_testFilename, std::ios::binary);
+                        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                    }
+                    if (compression == Compression::None)
+                    {
+                        if (format == SerializationFormat::Json && !encryption)
+                            uncompressedSize = contents.size();
+                    }
+                    else
+                    {
+                        // The codec is recorded next to the format and the data shrinks many times over
+                        ASSERT_EQ(contents.substr(0, 4), "DCOE") << name;
+                        ASSERT_EQ(static_cast<int>(contents[6]) & 0x3F, static_cast<int>(format) | (static_cast<int>(compression) << 4)) << name;
+                        ASSERT_LT(contents.size() * 10, uncompressedSize) << name;
+                    }
+
+                    // The reader detects the codec on its own
+                    std::optional<GameData> loadedData = DataReaderWriter::readData(m_testFilename, encryption);
+                    ASSERT_TRUE(loadedData.has_value()) << "Failed to read " << name << (encryption ? " (encrypted)" : "");
+                    ASSERT_EQ(loadedData.value(), gd) << name;
+                }
+            }
+        }
+
+        // Data that does not shrink is stored as is, so a small save never grows
+        GameData tiny("Tiny", 1);
+        WriteOptions options;
+        options.encryption = false;
+        options.compression = Compression::High;
+        ASSERT_TRUE(DataReaderWriter::writeData(tiny, m_testFilename, options));
+        {
+            std::ifstream file(m_testFilename, std::ios::binary);
+            ASSERT_EQ(file.get(), '{');
+        }
+        ASSERT_EQ(DataReaderWriter::readData(m_testFilename, false).value(), tiny);
+    }
+
+    TEST_F(DataReaderWriterTest, CorruptedCompressedDataRejected)
+    {
+        GameData gd(std::string(2000, 'x') + std::string(2000, 'y'), 7);
+
+        for (Compression compression : {Compression::Fast, Compression::High})
+        {
+            // Unencrypted, so nothing but the decompressor stands between the damage and the parser
+            WriteOptions options;
+            options.encryption = false;
+            options.compression = compression;
+            std::optional<std::string> encoded = DataReaderWriter::encode(gd, options);
+            ASSERT_TRUE(encoded.has_value());
+
+            ReadOptions readOptions;
+            readOptions.decryption = false;
+            ASSERT_EQ(DataReaderWriter::decode(*encoded, readOptions).value(), gd);
+
+            // Flipped bytes all over the stream may decode into other data or fail, but never read or write out of bounds
+            for (std::size_t i = 16; i < encoded->size(); i += 7)
+            {
+                std::string damaged = *encoded;
+                damaged[i] = static_cast<char>(damaged[i] ^ 0x5A);
+                DataReaderWriter::decode(damaged, readOptions);
+            }
+
+            // A truncated stream keeps its header length, so patch that too and try every length
+            for (std::size_t length = 16; length < encoded->size(); length += 3)
+            {
+                std::string truncated = encoded->substr(0, length);
+                std::uint64_t payloadLength = length - 16;
+                for (std::size_t b = 0; b < 8; b++)
+                    truncated[8 + b] = static_cast<char>((payloadLength >> (8 * b)) & 0xFF);
+                ASSERT_FALSE(DataReaderWriter::decode(truncated, readOptions).has_value()) << length;
+            }
+
+            // An original size far beyond what the stream could hold is refused before allocating it
+            std::string bomb = *encoded;
+            std::size_t stream = (bomb[6] & 0x40) ? 16 + 4 + static_cast<unsigned char>(bomb[16]) : 16; // after a summary block
+            bomb[stream + 7] = static_cast<char>(0x7F);
+            ASSERT_FALSE(DataReaderWriter::decode(bomb, readOptions).has_value());
+        }
+    }
+
+    TEST_F(DataReaderWriterTest, SummaryReadsOnlyTheFront)
+    {
+        // The summary block holds a copy of the summary fields, the whole GameData follows it
+        GameData gd("Summary", 1234);
+
+        for (bool encryption : {true, false})
+        {
+            for (SerializationFormat format : {SerializationFormat::Json, SerializationFormat::Cbor})
+            {
+                if (!encryption && format == SerializationFormat::Json)
+                    continue; // a plain text file, see below
+                std::string name = std::string(encryption ? "encrypted " : "") + std::to_string(static_cast<int>(format));
+                WriteOptions options;
+                options.encryption = encryption;
+                options.format = format;
+                std::string contents = DataReaderWriter::encode(gd, options).value();
+                {
+                    std::ofstream file(m_testFilename, std::ios::binary | std::ios::trunc);
+                    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+                }
+
+                // Only the summary fields are set
+                std::optional<GameData> summary = DataReaderWriter::readSummary(m_testFilename, encryption);
+                ASSERT_TRUE(summary.has_value()) << name;
+                ASSERT_EQ(summary->getNickname(), "Summary") << name;
+                ASSERT_EQ(summary->getHighscore(), 1234) << name;
+                ASSERT_EQ(DataReaderWriter::decodeSummary(contents, encryption).value().getHighscore(), 1234) << name;
+
+                // Damage past the summary block goes unnoticed by the summary read, but not by a full load
+                ASSERT_TRUE(contents[6] & 0x40) << name;
+                std::size_t payload = 16 + 4 + static_cast<unsigned char>(contents[16]) + (static_cast<unsigned char>(contents[17]) << 8);
+                ASSERT_LT(payload, contents.size()) << name;
+                for (std::size_t i = payload; i < contents.size(); i++)
+                    contents[i] = 'x';
+                {
+                    std::ofstream file(m_testFilename, std::ios::binary | std::ios::trunc);
+                    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+                }
+                ASSERT_EQ(DataReaderWriter::readSummary(m_testFilename, encryption).value().getHighscore(), 1234) << name;
+                ASSERT_FALSE(DataReaderWriter::readData(m_testFilename, encryption).has_value()) << name;
+
+                // The summary block is authenticated on its own
+                if (encryption)
+                {
+                    contents[40] = static_cast<char>(contents[40] ^ 0x01);
+                    {
+                        std::ofstream file(m_testFilename, std::ios::binary | std::ios::trunc);
+                        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+                    }
+                    ASSERT_FALSE(DataReaderWriter::readSummary(m_testFilename).has_value()) << name;
+                }
+            }
+        }
+
+        // Plain JSON, summaries too large for the block and saves of an older schema are read whole
+        GameData large(std::string(1000, 'L'), 5);
+        ASSERT_TRUE(DataReaderWriter::writeData(large, m_testFilename, true));
+        ASSERT_EQ(DataReaderWriter::readSummary(m_testFilename).value().getNickname(), large.getNickname());
+
+        ASSERT_TRUE(DataReaderWriter::writeData(GameData("Plain", 8), m_testFilename, false));
+        ASSERT_EQ(DataReaderWriter::readSummary(m_testFilename, false).value().getNickname(), "Plain");
+
+        {
+            std::ofstream file(m_testFilename, std::ios::binary | std::ios::trunc);
+            file << R"({"nickname":"Veteran","highscore":3,"schemaVersion":1})";
+        }
+        std::optional<GameData> old = DataReaderWriter::readSummary(m_testFilename, false);
+        ASSERT_TRUE(old.has_value());
+        ASSERT_EQ(old->getNickname(), "Veteran");
+        ASSERT_EQ(old->getHighscore(), 3);
+    }
 } // namespace datacoe
\ No newline at end of file
@@ -1,13 +1,17 @@
 #include <gtest/gtest.h>
 #include <datacoe/data_manager.hpp>
+#include <datacoe/data_reader_writer.hpp>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <signal.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #endif
 
@@ -339,4 +343,87 @@ namespace datacoe
         ASSERT_EQ(dm2.getGamedata().getHighscore(), 300);
     }
 
+    TEST_F(ErrorHandlingTest, CrashDuringAtomicSave)
+    {
+        // Saves go to a temporary file that is renamed over the save,
+        // a save that fails before the rename leaves the previous save untouched and no temporary file behind
+        auto readBytes = [](const std::string &path)
+        {
+            std::ifstream file(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        };
+        auto leftoverTemps = [](const std::string &filename)
+        {
+            std::vector<std::string> leftovers;
+            for (const auto &entry : std::filesystem::directory_iterator("."))
+            {
+                std::string name = entry.path().filename().string();
+                if (name.rfind(filename + ".tmp.", 0) == 0)
+                    leftovers.push_back(name);
+            }
+            return leftovers;
+        };
+
+        // First create valid data
+        DataManager dm;
+        bool initResult = dm.init(m_testFilename);
+        ASSERT_FALSE(initResult) << "init() should return false for new file";
+
+        dm.setDurability(Durability::Full);
+        dm.setGamedata(GameData("Original", 100));
+        ASSERT_TRUE(dm.saveGame()) << "Failed to save initial data";
+        const std::string original = readBytes(m_testFilename);
+
+#ifndef _WIN32
+        // The disk fills up in the middle of the next save: the file size limit makes the write fail part way
+        {
+            struct sigaction ignore{};
+            struct sigaction previousAction{};
+            ignore.sa_handler = SIG_IGN;
+            ASSERT_EQ(::sigaction(SIGXFSZ, &ignore, &previousAction), 0);
+            struct rlimit previousLimit{};
+            ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &previousLimit), 0);
+            struct rlimit limit = previousLimit;
+            limit.rlim_cur = 16;
+            ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limit), 0);
+
+            dm.setGamedata(GameData("TooLargeForTheDisk", 200));
+            bool saveResult = dm.saveGame();
+            bool writeResult = DataReaderWriter::writeData(GameData("TooLargeForTheDisk", 200), m_testFilename, false);
+
+            ::setrlimit(RLIMIT_FSIZE, &previousLimit);
+            ::sigaction(SIGXFSZ, &previousAction, nullptr);
+
+            ASSERT_FALSE(saveResult) << "saveGame() should fail when the write fails";
+            ASSERT_FALSE(writeResult) << "writeData() should fail when the write fails";
+            ASSERT_EQ(readBytes(m_testFilename), original) << "The previous save must be byte-identical";
+            ASSERT_TRUE(leftoverTemps(m_testFilename).empty()) << "Leftover temporary file: " << leftoverTemps(m_testFilename).front();
+            ASSERT_TRUE(dm.isDirty()) << "A failed save is not a save";
+        }
+#endif
+
+        // A target that can't be replaced (a directory) fails after the temporary file is written
+        const std::string directoryTarget = "error_test_directory_target";
+        std::filesystem::create_directory(directoryTarget);
+        ASSERT_FALSE(DataReaderWriter::writeData(GameData("NotAFile", 1), directoryTarget, false));
+        ASSERT_TRUE(std::filesystem::is_directory(directoryTarget));
+        ASSERT_TRUE(std::filesystem::is_empty(directoryTarget));
+        ASSERT_TRUE(leftoverTemps(directoryTarget).empty()) << "Leftover temporary file: " << leftoverTemps(directoryTarget).front();
+        std::filesystem::remove(directoryTarget);
+
+        // The previous save is still complete
+        DataManager reloaded;
+        ASSERT_TRUE(reloaded.init(m_testFilename)) << "init() should load the previous save after a failed save";
+        ASSERT_EQ(reloaded.getGamedata().getNickname(), "Original");
+        ASSERT_EQ(reloaded.getGamedata().getHighscore(), 100);
+
+        // And the next save replaces it as usual
+        reloaded.setGamedata(GameData("AfterCrash", 200));
+        ASSERT_TRUE(reloaded.saveGame()) << "Failed to save after interrupted save";
+
+        DataManager dm2;
+        ASSERT_TRUE(dm2.init(m_testFilename));
+        ASSERT_EQ(dm2.getGamedata().getNickname(), "AfterCrash");
+        ASSERT_EQ(dm2.getGamedata().getHighscore(), 200);
+    }
 } // namespace datacoe
\ No newline at end of file
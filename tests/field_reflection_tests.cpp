@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <datacoe/field_reflection.hpp>
+#include <datacoe/game_data.hpp>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace datacoe
+{
+    namespace
+    {
+        enum class Difficulty
+        {
+            Easy,
+            Hard
+        };
+
+        // What a fork's save data looks like, one field of every kind the templates handle differently
+        struct ForkData
+        {
+            std::string name;
+            bool tutorialDone = false;
+            std::uint8_t level = 0;
+            std::int64_t gold = 0;
+            double playTime = 0.0;
+            Difficulty difficulty = Difficulty::Easy;
+            std::vector<int> unlocked;
+            std::map<std::string, std::vector<std::string>> inventory;
+            std::string path;
+
+            static constexpr auto fields()
+            {
+                return std::make_tuple(field("name", &ForkData::name),
+                                       field("tutorialDone", &ForkData::tutorialDone),
+                                       field("level", &ForkData::level),
+                                       field("gold", &ForkData::gold),
+                                       field("playTime", &ForkData::playTime),
+                                       field("difficulty", &ForkData::difficulty),
+                                       field("unlocked", &ForkData::unlocked),
+                                       field("inventory", &ForkData::inventory),
+                                       field("save/path~", &ForkData::path));
+            }
+        };
+
+        ForkData sampleFork()
+        {
+            ForkData data;
+            data.name = "Forked";
+            data.tutorialDone = true;
+            data.level = 42;
+            data.gold = 9000000000;
+            data.playTime = 3600.5;
+            data.difficulty = Difficulty::Hard;
+            data.unlocked = {1, 2, 3};
+            data.inventory = {{"bag", {"potion", "rope"}}, {"chest", {}}};
+            data.path = "a/b";
+            return data;
+        }
+
+        bool operator==(const ForkData &a, const ForkData &b) { return reflection::equal(a, b); }
+    } // namespace
+
+    TEST(FieldReflectionTest, FieldList)
+    {
+        static_assert(reflection::fieldCount<GameData> == 2);
+        static_assert(reflection::fieldCount<ForkData> == 9);
+        static_assert(std::get<0>(reflection::fieldList<GameData>).key == "nickname");
+
+        ASSERT_EQ(reflection::findField<ForkData>("gold"), 3u);
+        ASSERT_EQ(reflection::findField<ForkData>("missing"), reflection::fieldCount<ForkData>);
+
+        std::vector<std::string_view> keys;
+        reflection::forEachField<GameData>([&keys](const auto &field)
+                                           { keys.push_back(field.key); });
+        ASSERT_EQ(keys, (std::vector<std::string_view>{"nickname", "highscore"}));
+    }
+
+    TEST(FieldReflectionTest, JsonRoundTrip)
+    {
+        ForkData data = sampleFork();
+        json j = reflection::toJson(data);
+        ASSERT_EQ(j["gold"], 9000000000);
+        ASSERT_EQ(j["inventory"]["bag"][1], "rope");
+        ASSERT_EQ(j["save/path~"], "a/b");
+
+        ASSERT_TRUE(reflection::fromJson<ForkData>(j) == data);
+        ASSERT_TRUE(reflection::fromJson<ForkData>(json(j)) == data);
+
+        // The first missing or mistyped field is named in the error
+        json missing = j;
+        missing.erase("playTime");
+        try
+        {
+            reflection::fromJson<ForkData>(missing);
+            FAIL() << "Expected std::runtime_error";
+        }
+        catch (const std::runtime_error &e)
+        {
+            ASSERT_NE(std::string(e.what()).find("'playTime'"), std::string::npos);
+        }
+
+        json mistyped = j;
+        mistyped["tutorialDone"] = 1;
+        ASSERT_THROW(reflection::fromJson<ForkData>(mistyped), std::runtime_error);
+    }
+
+    TEST(FieldReflectionTest, ParseEveryFormat)
+    {
+        ForkData data = sampleFork();
+        json j = reflection::toJson(data);
+        j["unknown"] = {{"nested", {1, 2, {{"deep", true}}}}};
+
+        std::string text = j.dump(), cbor, msgpack, bson;
+        json::to_cbor(j, cbor);
+        json::to_msgpack(j, msgpack);
+        json::to_bson(j, bson);
+
+        for (const auto &[bytes, format] : {std::make_pair(text, json::input_format_t::json),
+                                            std::make_pair(cbor, json::input_format_t::cbor),
+                                            std::make_pair(msgpack, json::input_format_t::msgpack),
+                                            std::make_pair(bson, json::input_format_t::bson)})
+        {
+            ForkData parsed = reflection::parse<ForkData>(bytes, format);
+            ASSERT_TRUE(parsed == data) << static_cast<int>(format);
+        }
+
+        // Integers are accepted for floating point fields, the other way around is a type error
+        json integral = j;
+        integral["playTime"] = 7;
+        ASSERT_EQ(reflection::parse<ForkData>(integral.dump(), json::input_format_t::json).playTime, 7.0);
+        integral["level"] = 1.5;
+        ASSERT_THROW(reflection::parse<ForkData>(integral.dump(), json::input_format_t::json), std::runtime_error);
+
+        // A nested field with the wrong shape is invalid like a mistyped scalar
+        json nested = j;
+        nested["unlocked"] = {{"not", "an array"}};
+        ASSERT_THROW(reflection::parse<ForkData>(nested.dump(), json::input_format_t::json), std::runtime_error);
+    }
+
+    TEST(FieldReflectionTest, DiffIsAJsonPatch)
+    {
+        ForkData from = sampleFork();
+        ForkData to = from;
+        ASSERT_TRUE(reflection::diff(from, to).empty());
+
+        to.gold += 1;
+        to.inventory["chest"].push_back("gem");
+        to.path = "c/d";
+        json patch = reflection::diff(from, to);
+        ASSERT_EQ(patch.size(), 3u);
+        ASSERT_EQ(patch[0]["path"], "/gold");
+        ASSERT_EQ(patch[2]["path"], "/save~1path~0");
+
+        json patched = reflection::toJson(from).patch(patch);
+        ASSERT_EQ(patched, reflection::toJson(to));
+
+        GameData before("Diff", 1);
+        GameData after("Diff", 2);
+        ASSERT_EQ(after.diff(before), json::parse(R"([{"op":"replace","path":"/highscore","value":2}])"));
+        ASSERT_EQ(before.toJson().patch(after.diff(before)), after.toJson());
+    }
+
+    TEST(FieldReflectionTest, Hash)
+    {
+        ForkData a = sampleFork();
+        ForkData b = sampleFork();
+        ASSERT_EQ(reflection::hash(a), reflection::hash(b));
+        b.unlocked.push_back(4); // hashed through its JSON text, std::vector has no std::hash
+        ASSERT_NE(reflection::hash(a), reflection::hash(b));
+
+        std::unordered_set<GameData> seen;
+        seen.insert(GameData("Player", 1));
+        seen.insert(GameData("Player", 1));
+        seen.insert(GameData("Player", 2));
+        ASSERT_EQ(seen.size(), 2u);
+        ASSERT_EQ(GameData("Hash", 5).hash(), std::hash<GameData>{}(GameData("Hash", 5)));
+    }
+} // namespace datacoe
\ No newline at end of file
@@ -214,4 +214,71 @@ namespace datacoe
         ASSERT_EQ(assigned.getHighscore(), 200);
     }
 
+    TEST(GameDataTest, ParseBasic)
+    {
+        GameData gd = GameData::parse(R"({"nickname":"SaxTest","highscore":400})");
+
+        ASSERT_EQ(gd.getNickname(), "SaxTest");
+        ASSERT_EQ(gd.getHighscore(), 400);
+    }
+
+    TEST(GameDataTest, ParseSkipsUnknownKeys)
+    {
+        // Unknown keys are skipped, including nested ones that reuse the field names
+        GameData gd = GameData::parse(
+            R"({"extra":{"nickname":7,"highscore":"x","list":[1,{"nickname":false}]},"nickname":"TestName","more":[null,true,1.5],"highscore":400})");
+
+        ASSERT_EQ(gd.getNickname(), "TestName");
+        ASSERT_EQ(gd.getHighscore(), 400);
+    }
+
+    TEST(GameDataTest, ParseKeepsFromJsonTypeChecks)
+    {
+        ASSERT_THROW(GameData::parse(R"({"highscore":400})"), std::runtime_error);
+        ASSERT_THROW(GameData::parse(R"({"nickname":"TestName"})"), std::runtime_error);
+        ASSERT_THROW(GameData::parse(R"({"nickname":12345,"highscore":400})"), std::runtime_error);
+        ASSERT_THROW(GameData::parse(R"({"nickname":"TestName","highscore":"400"})"), std::runtime_error);
+        ASSERT_THROW(GameData::parse(R"({"nickname":"TestName","highscore":4.5})"), std::runtime_error);
+        ASSERT_THROW(GameData::parse(R"({"nickname":["TestName"],"highscore":400})"), std::runtime_error);
+        ASSERT_THROW(GameData::parse(R"(["TestName",400])"), std::runtime_error);
+
+        // Malformed input fails like json::parse() does
+        ASSERT_THROW(GameData::parse(R"({"nickname":"TestName","highscore":)"), json::parse_error);
+    }
+
+    TEST(GameDataTest, ParseBinaryFormats)
+    {
+        GameData original("BinaryRoundTrip", 2147483647);
+        json j = original.toJson();
+
+        std::string cbor, msgpack, bson;
+        json::to_cbor(j, cbor);
+        json::to_msgpack(j, msgpack);
+        json::to_bson(j, bson);
+
+        for (const auto &[data, format] : {std::make_pair(cbor, json::input_format_t::cbor),
+                                           std::make_pair(msgpack, json::input_format_t::msgpack),
+                                           std::make_pair(bson, json::input_format_t::bson)})
+        {
+            GameData restored = GameData::parse(data, format);
+            ASSERT_EQ(restored.getNickname(), original.getNickname());
+            ASSERT_EQ(restored.getHighscore(), original.getHighscore());
+        }
+    }
+
+    TEST(GameDataTest, Equality)
+    {
+        GameData a("Equal", 100);
+        GameData b("Equal", 100);
+
+        ASSERT_TRUE(a == b);
+        ASSERT_FALSE(a != b);
+
+        b.setHighscore(101);
+        ASSERT_TRUE(a != b);
+
+        b = a;
+        b.setNickname("Different");
+        ASSERT_FALSE(a == b);
+    }
 } // namespace datacoe
\ No newline at end of file
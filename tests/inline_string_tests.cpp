@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <datacoe/inline_string.hpp>
+#include <datacoe/field_reflection.hpp>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+namespace datacoe
+{
+    namespace
+    {
+        // A save-menu profile made of fixed-size fields only, copied with a memcpy
+        struct Profile
+        {
+            InlineString<15> nickname;
+            InlineString<300> title;
+            int highscore = 0;
+
+            static constexpr auto fields()
+            {
+                return std::make_tuple(field("nickname", &Profile::nickname),
+                                       field("title", &Profile::title),
+                                       field("highscore", &Profile::highscore));
+            }
+        };
+    } // namespace
+
+    static_assert(std::is_trivially_copyable_v<InlineString<15>>);
+    static_assert(std::is_trivially_copyable_v<Profile>);
+    static_assert(sizeof(InlineString<15>) == 17, "15 bytes, the NUL and a one-byte size");
+
+    TEST(InlineStringTest, StoresTextInline)
+    {
+        InlineString<15> nickname = "Player One";
+        ASSERT_EQ(nickname.size(), 10u);
+        ASSERT_EQ(nickname, "Player One");
+        ASSERT_EQ(std::string("Player One"), nickname);
+        ASSERT_NE(nickname, std::string_view("Player Two"));
+        ASSERT_STREQ(nickname.c_str(), "Player One");
+        ASSERT_EQ(nickname.str(), "Player One");
+
+        // Copies are independent values
+        InlineString<15> copy = nickname;
+        ASSERT_TRUE(copy.assign("Renamed"));
+        ASSERT_EQ(nickname, "Player One");
+        ASSERT_TRUE(nickname < copy);
+
+        copy.clear();
+        ASSERT_TRUE(copy.empty());
+        ASSERT_STREQ(copy.c_str(), "");
+
+        std::unordered_set<InlineString<15>> names = {"a", "b", "a"};
+        ASSERT_EQ(names.size(), 2u);
+    }
+
+    TEST(InlineStringTest, OverflowPolicy)
+    {
+        // Exactly full is fine, one byte more is an error
+        InlineString<15> full(std::string(15, 'f'));
+        ASSERT_EQ(full.size(), InlineString<15>::capacity());
+        ASSERT_THROW(InlineString<15>(std::string(16, 'f')), std::length_error);
+
+        // assign() reports it and keeps the old value
+        ASSERT_FALSE(full.assign(std::string(16, 'g')));
+        ASSERT_EQ(full, std::string(15, 'f'));
+
+        // truncated() cuts explicitly, never inside a UTF-8 sequence
+        ASSERT_EQ(InlineString<4>::truncated("abcdef"), "abcd");
+        ASSERT_EQ(InlineString<4>::truncated("ab\xC3\xA9\xC3\xA9"), "ab\xC3\xA9");
+        ASSERT_EQ(InlineString<4>::truncated("abc\xE2\x82\xAC"), "abc");
+        ASSERT_EQ(InlineString<4>::truncated("ab"), "ab");
+    }
+
+    TEST(InlineStringTest, ReflectedFields)
+    {
+        Profile profile;
+        profile.nickname = "Inline";
+        profile.title = std::string(300, 't');
+        profile.highscore = 77;
+
+        json j = reflection::toJson(profile);
+        ASSERT_EQ(j["nickname"], "Inline");
+        Profile fromJson = reflection::fromJson<Profile>(j);
+        ASSERT_TRUE(reflection::equal(fromJson, profile));
+        ASSERT_EQ(reflection::hash(fromJson), reflection::hash(profile));
+
+        // Streamed straight from the parser in every format
+        std::vector<std::uint8_t> cbor = json::to_cbor(j);
+        for (const auto &[data, format] : {std::make_pair(j.dump(), json::input_format_t::json),
+                                           std::make_pair(std::string(cbor.begin(), cbor.end()), json::input_format_t::cbor)})
+        {
+            Profile parsed = reflection::parse<Profile>(data, format);
+            ASSERT_TRUE(reflection::equal(parsed, profile));
+        }
+
+        // A value too long for its field is rejected like one of the wrong type, naming the field
+        json tooLong = j;
+        tooLong["nickname"] = std::string(16, 'n');
+        try
+        {
+            reflection::fromJson<Profile>(tooLong);
+            FAIL() << "Expected std::runtime_error";
+        }
+        catch (const std::runtime_error &e)
+        {
+            ASSERT_NE(std::string(e.what()).find("'nickname'"), std::string::npos);
+        }
+        ASSERT_THROW(reflection::parse<Profile>(tooLong.dump(), json::input_format_t::json), std::runtime_error);
+
+        json mistyped = j;
+        mistyped["title"] = 5;
+        ASSERT_THROW(reflection::parse<Profile>(mistyped.dump(), json::input_format_t::json), std::runtime_error);
+
+        Profile changed = profile;
+        changed.nickname = "Changed";
+        ASSERT_EQ(reflection::diff(profile, changed), json::parse(R"([{"op":"replace","path":"/nickname","value":"Changed"}])"));
+    }
+} // namespace datacoe
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <datacoe/logger.hpp>
+#include <datacoe/data_reader_writer.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace datacoe
+{
+    class LoggerTest : public ::testing::Test
+    {
+    protected:
+        std::vector<std::pair<LogLevel, std::string>> m_messages;
+        LogLevel m_originalLevel = LogLevel::Info;
+
+        void SetUp() override
+        {
+            m_originalLevel = Logger::getLevel();
+            Logger::setSink([this](LogLevel level, const std::string &message)
+                            { m_messages.emplace_back(level, message); });
+        }
+
+        void TearDown() override
+        {
+            // Restore the default stdio sink and level for the other tests
+            Logger::setSink(nullptr);
+            Logger::setLevel(m_originalLevel);
+        }
+    };
+
+    TEST_F(LoggerTest, CustomSinkReceivesMessages)
+    {
+        Logger::setLevel(LogLevel::Trace);
+
+        DATACOE_LOG_ERROR("error " << 42);
+        DATACOE_LOG_WARNING("warning");
+
+        ASSERT_EQ(m_messages.size(), 2u);
+        ASSERT_EQ(m_messages[0].first, LogLevel::Error);
+        ASSERT_EQ(m_messages[0].second, "error 42");
+        ASSERT_EQ(m_messages[1].first, LogLevel::Warning);
+        ASSERT_EQ(m_messages[1].second, "warning");
+    }
+
+    TEST_F(LoggerTest, RuntimeLevelFiltersMessages)
+    {
+        Logger::setLevel(LogLevel::Error);
+
+        DATACOE_LOG_INFO("filtered info");
+        DATACOE_LOG_WARNING("filtered warning");
+        DATACOE_LOG_ERROR("kept error");
+
+        ASSERT_EQ(m_messages.size(), 1u);
+        ASSERT_EQ(m_messages[0].second, "kept error");
+
+        Logger::setLevel(LogLevel::Off);
+        DATACOE_LOG_ERROR("filtered error");
+        ASSERT_EQ(m_messages.size(), 1u);
+    }
+
+    TEST_F(LoggerTest, DisabledLevelDoesNotEvaluateArguments)
+    {
+        Logger::setLevel(LogLevel::Off);
+
+        int evaluations = 0;
+        auto expensive = [&evaluations]()
+        {
+            evaluations++;
+            return std::string("expensive");
+        };
+
+        DATACOE_LOG_ERROR(expensive());
+        DATACOE_LOG_TRACE(expensive());
+
+        ASSERT_EQ(evaluations, 0) << "Disabled log statements should not format their arguments";
+        ASSERT_TRUE(m_messages.empty());
+    }
+
+    TEST_F(LoggerTest, CompileTimeLevelIsRespected)
+    {
+        Logger::setLevel(LogLevel::Trace);
+
+        DATACOE_LOG_TRACE("trace");
+        DATACOE_LOG_DEBUG("debug");
+
+        size_t expected = 0;
+        if (Logger::COMPILE_TIME_MIN_LEVEL <= LogLevel::Trace)
+            expected++;
+        if (Logger::COMPILE_TIME_MIN_LEVEL <= LogLevel::Debug)
+            expected++;
+
+        ASSERT_EQ(m_messages.size(), expected);
+        ASSERT_FALSE(Logger::isEnabled(LogLevel::Off));
+    }
+
+    TEST_F(LoggerTest, LibraryErrorsGoThroughSink)
+    {
+        Logger::setLevel(LogLevel::Error);
+
+        std::optional<GameData> loadedData = DataReaderWriter::readData("non_existent_logger_file.json");
+        ASSERT_FALSE(loadedData.has_value());
+
+        ASSERT_FALSE(m_messages.empty()) << "readData() failure should be reported through the installed sink";
+        ASSERT_EQ(m_messages.back().first, LogLevel::Error);
+        ASSERT_NE(m_messages.back().second.find("readData()"), std::string::npos);
+    }
+} // namespace datacoe
\ No newline at end of file
@@ -1,11 +1,61 @@
 #include <gtest/gtest.h>
 #include <datacoe/data_manager.hpp>
+#include <atomic>
+#include <cstdlib>
 #include <filesystem>
+#include <iostream>
 #include <memory>
+#include <new>
 #include <vector>
 
+// Counts heap allocations made by the current thread while a datacoe::AllocationCounter is alive
+namespace
+{
+    thread_local bool g_countAllocations = false;
+    thread_local std::size_t g_allocations = 0;
+    thread_local std::size_t g_largeAllocations = 0;
+    thread_local std::size_t g_largeThreshold = 0;
+
+    void *countedAlloc(std::size_t size)
+    {
+        if (g_countAllocations)
+        {
+            g_allocations++;
+            if (size >= g_largeThreshold)
+                g_largeAllocations++;
+        }
+        if (void *p = std::malloc(size == 0 ? 1 : size))
+            return p;
+        throw std::bad_alloc();
+    }
+} // namespace
+
+void *operator new(std::size_t size) { return countedAlloc(size); }
+void *operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
 namespace datacoe
 {
+    // Allocations on this thread during the counter's lifetime, large ones are at least largeThreshold bytes
+    class AllocationCounter
+    {
+    public:
+        explicit AllocationCounter(std::size_t largeThreshold)
+        {
+            g_allocations = 0;
+            g_largeAllocations = 0;
+            g_largeThreshold = largeThreshold;
+            g_countAllocations = true;
+        }
+        ~AllocationCounter() { g_countAllocations = false; }
+
+        std::size_t total() const { return g_allocations; }
+        std::size_t large() const { return g_largeAllocations; }
+    };
+
     class MemoryTest : public ::testing::Test
     {
     protected:
@@ -171,4 +221,107 @@ namespace datacoe
             ASSERT_FALSE(data.getNickname().empty());
         }
     }
+
+    TEST_F(MemoryTest, AllocationsPerSaveLoadCycle)
+    {
+        // A nickname far beyond the small string buffer, every copy of it is one large allocation
+        constexpr std::size_t nicknameSize = 64 * 1024;
+
+        DataManager dm;
+        dm.init(m_testFilename);
+
+        // Moving strings in never copies them
+        {
+            std::string nickname(nicknameSize, 'M');
+            AllocationCounter counter(nicknameSize);
+            GameData gamedata(std::move(nickname), 1);
+            gamedata.setNickname(std::string(gamedata.getNickname().size(), 'N')); // the only copy is made by the caller
+            ASSERT_EQ(counter.large(), 1u);
+        }
+
+        // Setting GameData copies nothing beyond what the caller passes in, the getSnapshot() copy waits for a reader
+        {
+            GameData gamedata(std::string(nicknameSize, 'M'), 1);
+            AllocationCounter copyCounter(nicknameSize);
+            dm.setGamedata(gamedata);
+            ASSERT_EQ(copyCounter.large(), 1u) << "copy into the manager only";
+        }
+        {
+            GameData gamedata(std::string(nicknameSize, 'N'), 1);
+            AllocationCounter moveCounter(nicknameSize);
+            dm.setGamedata(std::move(gamedata));
+            ASSERT_EQ(moveCounter.large(), 0u);
+        }
+        {
+            std::string nickname(nicknameSize, 'E');
+            AllocationCounter counter(nicknameSize);
+            dm.emplaceGamedata(std::move(nickname), 2);
+            ASSERT_EQ(counter.large(), 0u);
+        }
+        {
+            AllocationCounter counter(nicknameSize);
+            dm.updateGamedata([](GameData &gd)
+                              { gd.setHighscore(gd.getHighscore() + 1); });
+            ASSERT_EQ(counter.large(), 0u);
+            ASSERT_TRUE(dm.isDirty());
+
+            // the first read after the changes makes the one snapshot copy, the next ones share it
+            ASSERT_EQ(dm.getSnapshot()->getHighscore(), 3);
+            ASSERT_EQ(counter.large(), 1u);
+            ASSERT_EQ(dm.getSnapshot(), dm.getSnapshot());
+            ASSERT_EQ(counter.large(), 1u);
+        }
+
+        // fromJson() on a json that is no longer needed takes its strings
+        {
+            json j = dm.getGamedata().toJson();
+            AllocationCounter counter(nicknameSize);
+            GameData copied = GameData::fromJson(j);
+            ASSERT_EQ(counter.large(), 1u);
+            GameData moved = GameData::fromJson(std::move(j));
+            ASSERT_EQ(counter.large(), 1u);
+            ASSERT_EQ(moved, copied);
+        }
+
+        // A full cycle, repeated to show the counts are steady. What remains is buffers the steps need, no GameData copies
+        // saveGame(): snapshot of the changed data, json DOM, summary fields, serialized document and summary (dropped, too large for a summary block), ciphertext
+        // loadGame(): file data, plaintext, parser token buffer (grown twice) and the string taken from it
+        constexpr std::size_t saveBuffers = 6;
+        constexpr std::size_t loadBuffers = 5;
+        std::size_t steadySaveTotal = 0;
+        std::size_t steadyLoadTotal = 0;
+        for (int cycle = 0; cycle < 3; cycle++)
+        {
+            dm.updateGamedata([cycle](GameData &gd)
+                              { gd.setHighscore(cycle); });
+
+            AllocationCounter saveCounter(nicknameSize);
+            ASSERT_TRUE(dm.saveGame());
+            std::size_t saveLarge = saveCounter.large();
+            std::size_t saveTotal = saveCounter.total();
+
+            AllocationCounter loadCounter(nicknameSize);
+            ASSERT_TRUE(dm.loadGame());
+            std::size_t loadLarge = loadCounter.large();
+            std::size_t loadTotal = loadCounter.total();
+            std::cout << "  cycle " << cycle << ": saveGame() " << saveTotal << " allocations (" << saveLarge << " large), loadGame() "
+                      << loadTotal << " allocations (" << loadLarge << " large)" << std::endl;
+            ASSERT_EQ(dm.getGamedata().getHighscore(), cycle);
+
+            ASSERT_EQ(saveLarge, saveBuffers) << "cycle " << cycle;
+            ASSERT_EQ(loadLarge, loadBuffers) << "cycle " << cycle;
+
+            // the first cycle also sets up state the later ones reuse, those allocate exactly the same
+            if (cycle == 1)
+            {
+                steadySaveTotal = saveTotal;
+                steadyLoadTotal = loadTotal;
+            }
+            else if (cycle > 1)
+            {
+                ASSERT_EQ(saveTotal, steadySaveTotal) << "cycle " << cycle;
+                ASSERT_EQ(loadTotal, steadyLoadTotal) << "cycle " << cycle;
+            }
+        }
+    }
 } // namespace datacoe
\ No newline at end of file
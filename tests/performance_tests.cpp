@@ -1,12 +1,16 @@
 #include <gtest/gtest.h>
 #include <datacoe/data_manager.hpp>
 #include <datacoe/data_reader_writer.hpp>
+#include <datacoe/save_slots.hpp>
+#include <datacoe/inline_string.hpp>
 #include <filesystem>
+#include <fstream>
 #include <chrono>
 #include <vector>
 #include <random>
 #include <algorithm>
 #include <iostream>
+#include <thread>
 
 namespace datacoe
 {
@@ -384,4 +388,512 @@ namespace datacoe
         { /* Ignore cleanup errors */
         }
     }
+
+    TEST_F(PerformanceTest, DurabilityLatencyComparison)
+    {
+        constexpr int iterations = 20;
+
+        GameData testData("DurabilityTest", 12345);
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "     Save Latency per Durability Level" << std::endl;
+        std::cout << "=============================================" << std::endl;
+        std::cout << std::fixed << std::setprecision(2);
+
+        const std::pair<Durability, const char *> levels[] = {
+            {Durability::None, "None (rename only)"},
+            {Durability::Data, "Data (fdatasync)"},
+            {Durability::Full, "Full (fsync + directory)"}};
+
+        for (const auto &[durability, name] : levels)
+        {
+            WriteOptions options;
+            options.durability = durability;
+
+            std::vector<long long> timings;
+            timings.reserve(iterations);
+
+            for (int i = 0; i < iterations; i++)
+            {
+                testData.setHighscore(12345 + i);
+                auto duration = measureExecutionTime([&]()
+                                                     { ASSERT_TRUE(DataReaderWriter::writeData(testData, m_testFilename, options)); });
+                timings.push_back(duration);
+            }
+
+            double avg = 0.0;
+            for (auto time : timings)
+            {
+                avg += time;
+            }
+            avg /= iterations;
+
+            std::sort(timings.begin(), timings.end());
+            std::cout << "  " << name << ": average " << avg << "us, median " << timings[iterations / 2] << "us" << std::endl;
+        }
+        std::cout << "=============================================" << std::endl;
+
+        std::optional<GameData> loadedData = DataReaderWriter::readData(m_testFilename);
+        ASSERT_TRUE(loadedData.has_value());
+        ASSERT_EQ(loadedData.value().getHighscore(), 12345 + iterations - 1);
+    }
+
+    TEST_F(PerformanceTest, CryptoContextReuse)
+    {
+        constexpr int iterations = 20;
+
+        GameData testData("CryptoContextTest", 4321);
+
+        // The first encrypted save and load on a thread pay for seeding the RNG and expanding the
+        // AES key schedule (what every call used to pay), later calls on that thread reuse them
+        long long coldWriteTotal = 0, warmWriteTotal = 0, coldReadTotal = 0, warmReadTotal = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            std::thread worker([&]()
+                               {
+                coldWriteTotal += measureExecutionTime([&]()
+                                                       { EXPECT_TRUE(DataReaderWriter::writeData(testData, m_testFilename, true)); });
+                warmWriteTotal += measureExecutionTime([&]()
+                                                       { EXPECT_TRUE(DataReaderWriter::writeData(testData, m_testFilename, true)); });
+                coldReadTotal += measureExecutionTime([&]()
+                                                      { EXPECT_TRUE(DataReaderWriter::readData(m_testFilename).has_value()); });
+                warmReadTotal += measureExecutionTime([&]()
+                                                      { EXPECT_TRUE(DataReaderWriter::readData(m_testFilename).has_value()); }); });
+            worker.join();
+        }
+
+        // Fresh threads only, so the cold measurements include the context construction
+        // while the warm ones run with it already in place
+        double coldWrite = static_cast<double>(coldWriteTotal) / iterations;
+        double warmWrite = static_cast<double>(warmWriteTotal) / iterations;
+        double coldRead = static_cast<double>(coldReadTotal) / iterations;
+        double warmRead = static_cast<double>(warmReadTotal) / iterations;
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "     Per-Thread Crypto Context Reuse" << std::endl;
+        std::cout << "=============================================" << std::endl;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "  Encrypted save, new context:    " << coldWrite << "us" << std::endl;
+        std::cout << "  Encrypted save, cached context: " << warmWrite << "us" << std::endl;
+        std::cout << "  Encrypted load, new context:    " << coldRead << "us" << std::endl;
+        std::cout << "  Encrypted load, cached context: " << warmRead << "us" << std::endl;
+        std::cout << "  Per-call setup saved: ~" << (coldWrite - warmWrite) << "us per save" << std::endl;
+        std::cout << "=============================================" << std::endl;
+
+        std::optional<GameData> loadedData = DataReaderWriter::readData(m_testFilename);
+        ASSERT_TRUE(loadedData.has_value());
+        ASSERT_EQ(loadedData.value().getNickname(), "CryptoContextTest");
+    }
+
+    TEST_F(PerformanceTest, SerializationFormatComparison)
+    {
+        constexpr int iterations = 50;
+
+        // Long nickname and large score, the same data in every format
+        GameData testData(std::string(200, 'n'), 1234567890);
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "     Save Size and Load Time per Format" << std::endl;
+        std::cout << "=============================================" << std::endl;
+        std::cout << std::fixed << std::setprecision(2);
+
+        const std::pair<SerializationFormat, const char *> formats[] = {
+            {SerializationFormat::Json, "JSON"},
+            {SerializationFormat::Cbor, "CBOR"},
+            {SerializationFormat::MessagePack, "MessagePack"},
+            {SerializationFormat::Bson, "BSON"}};
+
+        for (const auto &[format, name] : formats)
+        {
+            WriteOptions options;
+            options.format = format;
+            ASSERT_TRUE(DataReaderWriter::writeData(testData, m_testFilename, options));
+            auto fileSize = std::filesystem::file_size(m_testFilename);
+
+            long long total = 0;
+            for (int i = 0; i < iterations; i++)
+            {
+                total += measureExecutionTime([&]()
+                                              { ASSERT_TRUE(DataReaderWriter::readData(m_testFilename).has_value()); });
+            }
+
+            std::cout << "  " << name << ": " << fileSize << " bytes, load average "
+                      << static_cast<double>(total) / iterations << "us" << std::endl;
+        }
+        std::cout << "=============================================" << std::endl;
+    }
+
+    TEST_F(PerformanceTest, AsyncSaveCallerLatency)
+    {
+        constexpr int iterations = 50;
+
+        DataManager dm;
+        dm.init(m_testFilename);
+        dm.setGamedata(GameData("AsyncLatency", 1));
+
+        // Time spent on the calling (game) thread only, the async writes finish in the background
+        std::vector<long long> syncTimings, asyncTimings;
+        for (int i = 0; i < iterations; i++)
+        {
+            dm.setGamedata(GameData("AsyncLatency", i));
+            syncTimings.push_back(measureExecutionTime([&]()
+                                                       { ASSERT_TRUE(dm.saveGame()); }));
+        }
+
+        std::vector<std::future<bool>> results;
+        for (int i = 0; i < iterations; i++)
+        {
+            dm.setGamedata(GameData("AsyncLatency", i));
+            asyncTimings.push_back(measureExecutionTime([&]()
+                                                        { results.push_back(dm.saveGameAsync()); }));
+        }
+        for (std::future<bool> &result : results)
+            ASSERT_TRUE(result.get());
+
+        std::sort(syncTimings.begin(), syncTimings.end());
+        std::sort(asyncTimings.begin(), asyncTimings.end());
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "     Save Latency on the Calling Thread" << std::endl;
+        std::cout << "=============================================" << std::endl;
+        std::cout << "  saveGame():      median " << syncTimings[iterations / 2] << "us, max " << syncTimings.back() << "us" << std::endl;
+        std::cout << "  saveGameAsync(): median " << asyncTimings[iterations / 2] << "us, max " << asyncTimings.back() << "us" << std::endl;
+        std::cout << "  Coalesced async saves: " << dm.getCoalescedSaveCount() << " of " << iterations << std::endl;
+        std::cout << "=============================================" << std::endl;
+    }
+
+    TEST_F(PerformanceTest, SlotListingWithIndex)
+    {
+        constexpr int slotCount = 1000;
+        const std::string directory = "perf_test_slots";
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+        std::filesystem::create_directories(directory);
+
+        for (int i = 0; i < slotCount; i++)
+        {
+            std::string path = (std::filesystem::path(directory) / ("slot" + std::to_string(i) + SaveSlots::SLOT_EXTENSION)).string();
+            ASSERT_TRUE(DataReaderWriter::writeData(GameData("Player" + std::to_string(i), i), path));
+        }
+
+        // First open finds no index and builds it from every slot file
+        auto rebuildTime = measureExecutionTime([&]()
+                                                {
+            SaveSlots slots;
+            ASSERT_TRUE(slots.open(directory));
+            ASSERT_EQ(slots.size(), static_cast<size_t>(slotCount)); });
+
+        // What a save menu does: open the directory and list every slot
+        std::vector<SlotInfo> listed;
+        auto indexTime = measureExecutionTime([&]()
+                                              {
+            SaveSlots slots;
+            ASSERT_TRUE(slots.open(directory));
+            listed = slots.list(); });
+        ASSERT_EQ(listed.size(), static_cast<size_t>(slotCount));
+
+        // The same without an index: open, decrypt and parse every slot
+        int readCount = 0;
+        auto readAllTime = measureExecutionTime([&]()
+                                                {
+            for (int i = 0; i < slotCount; i++)
+            {
+                std::string path = (std::filesystem::path(directory) / ("slot" + std::to_string(i) + SaveSlots::SLOT_EXTENSION)).string();
+                if (DataReaderWriter::readData(path).has_value())
+                    readCount++;
+            } });
+        ASSERT_EQ(readCount, slotCount);
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "     Listing " << slotCount << " Save Slots" << std::endl;
+        std::cout << "=============================================" << std::endl;
+        std::cout << "  Index rebuild (first open): " << rebuildTime / 1000.0 << "ms" << std::endl;
+        std::cout << "  Open + list from index:     " << indexTime / 1000.0 << "ms" << std::endl;
+        std::cout << "  readData() on every slot:   " << readAllTime / 1000.0 << "ms" << std::endl;
+        std::cout << "=============================================" << std::endl;
+
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    TEST_F(PerformanceTest, JournalCheckpointSaves)
+    {
+        constexpr int checkpoints = 50;
+        const std::string nickname(512 * 1024, 'N'); // stands in for a large save where one field changes per checkpoint
+        const std::string journalFilename = m_testFilename + ".journal";
+
+        auto runCheckpoints = [&](bool journal)
+        {
+            std::filesystem::remove(m_testFilename);
+            std::filesystem::remove(journalFilename);
+
+            JournalOptions options;
+            options.maxRecords = checkpoints * 2; // measure the appends, not the compaction
+            DataManager dm;
+            if (journal)
+                dm.enableJournal(options);
+            dm.init(m_testFilename);
+            dm.setGamedata(GameData(nickname, 0));
+            EXPECT_TRUE(dm.saveGame());
+
+            std::vector<long long> timings;
+            for (int i = 1; i <= checkpoints; i++)
+            {
+                dm.setGamedata(GameData(nickname, i));
+                timings.push_back(measureExecutionTime([&]()
+                                                       { EXPECT_TRUE(dm.saveGame()); }));
+            }
+            std::sort(timings.begin(), timings.end());
+            return timings[checkpoints / 2];
+        };
+
+        long long fullMedian = runCheckpoints(false);
+        long long journalMedian = runCheckpoints(true);
+        auto fileSize = std::filesystem::file_size(m_testFilename);
+        auto recordBytes = (std::filesystem::file_size(journalFilename) - 20) / checkpoints; // after the 20-byte journal header
+
+        // Loading has to replay every record on top of the file
+        DataManager loader;
+        auto loadTime = measureExecutionTime([&]()
+                                             { ASSERT_TRUE(loader.init(m_testFilename)); });
+        ASSERT_EQ(loader.getGamedata().getHighscore(), checkpoints);
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "     Checkpoint Saves of " << fileSize / 1024 << "KB GameData" << std::endl;
+        std::cout << "=============================================" << std::endl;
+        std::cout << "  Whole file per save: median " << fullMedian << "us, " << fileSize << " bytes per save" << std::endl;
+        std::cout << "  Journal record:      median " << journalMedian << "us, " << recordBytes << " bytes per save" << std::endl;
+        std::cout << "  Load with " << checkpoints << " records: " << loadTime / 1000.0 << "ms" << std::endl;
+        std::cout << "=============================================" << std::endl;
+
+        std::filesystem::remove(journalFilename);
+    }
+
+    TEST_F(PerformanceTest, InitAsyncTimeToFirstFrame)
+    {
+        const std::vector<std::size_t> sizes = {1024, 1024 * 1024, 16 * 1024 * 1024};
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "     Startup Time Spent in init()" << std::endl;
+        std::cout << "=============================================" << std::endl;
+        for (std::size_t size : sizes)
+        {
+            ASSERT_TRUE(DataReaderWriter::writeData(GameData(std::string(size, 'F'), 1), m_testFilename));
+
+            DataManager blocking;
+            auto initTime = measureExecutionTime([&]()
+                                                 { ASSERT_TRUE(blocking.init(m_testFilename)); });
+
+            // The game thread only pays for starting the load, the first frame can render while it runs
+            DataManager async;
+            LoadTask task;
+            auto initAsyncTime = measureExecutionTime([&]()
+                                                      { task = async.initAsync(m_testFilename); });
+            auto loadTime = measureExecutionTime([&]()
+                                                 { ASSERT_TRUE(task.get()); });
+
+            std::cout << "  " << size / 1024 << "KB save: init() " << initTime << "us, initAsync() " << initAsyncTime
+                      << "us (load done " << loadTime << "us later)" << std::endl;
+        }
+        std::cout << "=============================================" << std::endl;
+    }
+
+    TEST_F(PerformanceTest, BatchThroughputScaling)
+    {
+        constexpr int saveCount = 2000;
+        const std::string directory = "perf_test_batch";
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+        std::filesystem::create_directories(directory);
+
+        std::vector<std::pair<GameData, std::string>> jobs;
+        std::vector<std::string> filenames;
+        for (int i = 0; i < saveCount; i++)
+        {
+            std::string filename = directory + "/player" + std::to_string(i) + ".data";
+            jobs.emplace_back(GameData("Player" + std::to_string(i) + std::string(2048, 'x'), i), filename);
+            filenames.push_back(filename);
+        }
+
+        std::vector<std::size_t> threadCounts = {1, 2, 4, 8};
+        std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        if (std::find(threadCounts.begin(), threadCounts.end(), cores) == threadCounts.end())
+            threadCounts.push_back(cores);
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "     Batch Throughput, " << saveCount << " Saves (" << cores << " cores)" << std::endl;
+        std::cout << "=============================================" << std::endl;
+        for (std::size_t threads : threadCounts)
+        {
+            std::vector<bool> written;
+            auto writeTime = measureExecutionTime([&]()
+                                                  { written = DataReaderWriter::writeMany(jobs, WriteOptions(), threads); });
+            ASSERT_EQ(std::count(written.begin(), written.end(), true), saveCount);
+
+            std::vector<std::optional<GameData>> loaded;
+            auto readTime = measureExecutionTime([&]()
+                                                 { loaded = DataReaderWriter::readMany(filenames, ReadOptions(), threads); });
+            ASSERT_EQ(std::count_if(loaded.begin(), loaded.end(), [](const std::optional<GameData> &gd)
+                                    { return gd.has_value(); }),
+                      saveCount);
+
+            std::cout << "  " << threads << " threads: write " << saveCount * 1000000.0 / writeTime << " saves/s, read "
+                      << saveCount * 1000000.0 / readTime << " saves/s" << std::endl;
+        }
+        std::cout << "=============================================" << std::endl;
+
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    TEST_F(PerformanceTest, CompressionComparison)
+    {
+        constexpr int iterations = 50;
+
+        // Structured, repetitive text like an inventory serialized into the save
+        std::string inventory;
+        for (int i = 0; inventory.size() < 64 * 1024; i++)
+            inventory += "{\"item\":\"potion_" + std::to_string(i % 16) + "\",\"count\":" + std::to_string(i % 10) + ",\"equipped\":false},";
+        GameData testData(inventory, 1234567890);
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "   Encrypted Save Size and Time per Codec" << std::endl;
+        std::cout << "=============================================" << std::endl;
+        std::cout << std::fixed << std::setprecision(2);
+
+        const std::pair<Compression, const char *> codecs[] = {
+            {Compression::None, "None"},
+            {Compression::Fast, "Fast"},
+            {Compression::High, "High"}};
+
+        std::uintmax_t uncompressedSize = 0;
+        for (const auto &[compression, name] : codecs)
+        {
+            WriteOptions options;
+            options.compression = compression;
+
+            long long saveTotal = 0;
+            long long loadTotal = 0;
+            for (int i = 0; i < iterations; i++)
+            {
+                saveTotal += measureExecutionTime([&]()
+                                                  { ASSERT_TRUE(DataReaderWriter::writeData(testData, m_testFilename, options)); });
+                loadTotal += measureExecutionTime([&]()
+                                                  { ASSERT_TRUE(DataReaderWriter::readData(m_testFilename).has_value()); });
+            }
+            auto fileSize = std::filesystem::file_size(m_testFilename);
+            if (compression == Compression::None)
+                uncompressedSize = fileSize;
+            else
+                ASSERT_LT(fileSize * 4, uncompressedSize) << name;
+
+            std::cout << "  " << name << ": " << fileSize << " bytes, save average " << static_cast<double>(saveTotal) / iterations
+                      << "us, load average " << static_cast<double>(loadTotal) / iterations << "us" << std::endl;
+        }
+        std::cout << "=============================================" << std::endl;
+    }
+
+    TEST_F(PerformanceTest, SummaryReadOfProfiles)
+    {
+        constexpr int profileCount = 100;
+        const std::string directory = "perf_test_summaries";
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+        std::filesystem::create_directories(directory);
+
+        // The stock GameData is no larger than its summary, so both reads cost about the same here
+        // The summary read pulls ahead once a game adds large fields outside GameData::summaryFields()
+        std::vector<std::string> paths;
+        for (int i = 0; i < profileCount; i++)
+        {
+            GameData gd("Player" + std::to_string(i), i);
+            std::string contents = DataReaderWriter::encode(gd, WriteOptions()).value();
+            paths.push_back((std::filesystem::path(directory) / ("profile" + std::to_string(i) + ".sav")).string());
+            std::ofstream file(paths.back(), std::ios::binary | std::ios::trunc);
+            file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        }
+        auto fileSize = std::filesystem::file_size(paths.front());
+
+        // What a profile picker needs: the nickname and highscore of every profile
+        int summaryCount = 0;
+        auto summaryTime = measureExecutionTime([&]()
+                                                {
+            for (int i = 0; i < profileCount; i++)
+            {
+                std::optional<GameData> summary = DataReaderWriter::readSummary(paths[i]);
+                if (summary && summary->getHighscore() == i)
+                    summaryCount++;
+            } });
+        ASSERT_EQ(summaryCount, profileCount);
+
+        int readCount = 0;
+        auto readAllTime = measureExecutionTime([&]()
+                                                {
+            for (int i = 0; i < profileCount; i++)
+            {
+                std::optional<GameData> gamedata = DataReaderWriter::readData(paths[i]);
+                if (gamedata && gamedata->getHighscore() == i)
+                    readCount++;
+            } });
+        ASSERT_EQ(readCount, profileCount);
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "     Listing " << profileCount << " Profiles of " << fileSize << " bytes" << std::endl;
+        std::cout << "=============================================" << std::endl;
+        std::cout << "  readSummary() on every profile: " << summaryTime / 1000.0 << "ms (" << DataReaderWriter::SUMMARY_READ_SIZE
+                  << " bytes each)" << std::endl;
+        std::cout << "  readData() on every profile:    " << readAllTime / 1000.0 << "ms" << std::endl;
+        std::cout << "=============================================" << std::endl;
+
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    TEST_F(PerformanceTest, InlineStringProfileCopies)
+    {
+        constexpr int profileCount = 100000;
+        constexpr int iterations = 10;
+
+        // The same profile with a heap-allocated and an inline nickname, longer than the small-string buffer
+        struct HeapProfile
+        {
+            std::string nickname;
+            int highscore = 0;
+        };
+        struct InlineProfile
+        {
+            InlineString<31> nickname;
+            int highscore = 0;
+        };
+
+        std::vector<HeapProfile> heapProfiles;
+        std::vector<InlineProfile> inlineProfiles;
+        for (int i = 0; i < profileCount; i++)
+        {
+            std::string nickname = "LongPlayerNickname_" + std::to_string(i);
+            heapProfiles.push_back({nickname, i});
+            inlineProfiles.push_back({InlineString<31>(nickname), i});
+        }
+
+        std::size_t checksum = 0;
+        auto heapTime = measureExecutionTime([&]()
+                                             {
+            for (int i = 0; i < iterations; i++)
+            {
+                std::vector<HeapProfile> copy = heapProfiles;
+                checksum += copy.back().nickname.size();
+            } });
+        auto inlineTime = measureExecutionTime([&]()
+                                               {
+            for (int i = 0; i < iterations; i++)
+            {
+                std::vector<InlineProfile> copy = inlineProfiles;
+                checksum += copy.back().nickname.size();
+            } });
+        ASSERT_EQ(checksum, 2u * iterations * heapProfiles.back().nickname.size());
+
+        std::cout << "=============================================" << std::endl;
+        std::cout << "     Copying " << profileCount << " Profiles x" << iterations << std::endl;
+        std::cout << "=============================================" << std::endl;
+        std::cout << "  std::string nickname:      " << heapTime / 1000.0 << "ms" << std::endl;
+        std::cout << "  InlineString<31> nickname: " << inlineTime / 1000.0 << "ms" << std::endl;
+        std::cout << "=============================================" << std::endl;
+    }
 } // namespace datacoe
\ No newline at end of file
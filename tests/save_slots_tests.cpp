@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include <datacoe/save_slots.hpp>
+#include <datacoe/data_reader_writer.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace datacoe
+{
+    class SaveSlotsTest : public ::testing::Test
+    {
+    protected:
+        std::string m_directory;
+
+        void SetUp() override
+        {
+            m_directory = "test_save_slots";
+            std::error_code ec;
+            std::filesystem::remove_all(m_directory, ec);
+        }
+
+        void TearDown() override
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(m_directory, ec);
+        }
+
+        std::string pathOf(const std::string &file) const
+        {
+            return (std::filesystem::path(m_directory) / file).string();
+        }
+
+        void writeFile(const std::string &path, const std::string &contents)
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file << contents;
+        }
+    };
+
+    TEST_F(SaveSlotsTest, SaveListAndLoad)
+    {
+        SaveSlots slots;
+        ASSERT_TRUE(slots.open(m_directory));
+        ASSERT_EQ(slots.size(), 0u);
+
+        ASSERT_TRUE(slots.save("slot2", GameData("Second", 200)));
+        ASSERT_TRUE(slots.save("slot1", GameData("First", 100)));
+        ASSERT_TRUE(slots.save("slot3", GameData("Third", 300)));
+        ASSERT_TRUE(std::filesystem::exists(pathOf(SaveSlots::INDEX_FILENAME)));
+        ASSERT_FALSE(std::filesystem::exists(pathOf(SaveSlots::PENDING_FILENAME)));
+
+        std::vector<SlotInfo> list = slots.list();
+        ASSERT_EQ(list.size(), 3u);
+        ASSERT_EQ(list[0].name, "slot1");
+        ASSERT_EQ(list[0].nickname, "First");
+        ASSERT_EQ(list[0].highscore, 100);
+        ASSERT_EQ(list[2].name, "slot3");
+        ASSERT_GT(list[0].timestamp, 0);
+        ASSERT_EQ(list[0].size, std::filesystem::file_size(pathOf("slot1.sav")));
+        ASSERT_NE(list[0].checksum, list[1].checksum);
+
+        std::optional<GameData> loaded = slots.load("slot2");
+        ASSERT_TRUE(loaded.has_value());
+        ASSERT_EQ(loaded.value().getNickname(), "Second");
+        ASSERT_EQ(loaded.value().getHighscore(), 200);
+        ASSERT_TRUE(DataReaderWriter::isFileEncrypted(pathOf("slot2.sav")));
+
+        // Overwriting updates the entry
+        ASSERT_TRUE(slots.save("slot2", GameData("Second", 250)));
+        ASSERT_EQ(slots.info("slot2").value().highscore, 250);
+        ASSERT_EQ(slots.size(), 3u);
+
+        ASSERT_TRUE(slots.remove("slot2"));
+        ASSERT_FALSE(slots.info("slot2").has_value());
+        ASSERT_FALSE(std::filesystem::exists(pathOf("slot2.sav")));
+        ASSERT_FALSE(slots.remove("slot2"));
+
+        // A fresh instance lists the same slots from the index
+        SaveSlots reopened;
+        ASSERT_TRUE(reopened.open(m_directory));
+        ASSERT_EQ(reopened.size(), 2u);
+        ASSERT_EQ(reopened.info("slot3").value().nickname, "Third");
+        ASSERT_EQ(reopened.info("slot3").value().checksum, slots.info("slot3").value().checksum);
+    }
+
+    TEST_F(SaveSlotsTest, ListingReadsOnlyTheIndex)
+    {
+        {
+            SaveSlots slots;
+            ASSERT_TRUE(slots.open(m_directory));
+            ASSERT_TRUE(slots.save("indexed", GameData("FromIndex", 1)));
+        }
+
+        // Damage the slot file behind the index's back, listing must not notice
+        writeFile(pathOf("indexed.sav"), "garbage");
+
+        SaveSlots slots;
+        ASSERT_TRUE(slots.open(m_directory));
+        ASSERT_EQ(slots.info("indexed").value().nickname, "FromIndex");
+        ASSERT_FALSE(slots.load("indexed").has_value());
+
+        // A rebuild reads the slot files and leaves the unreadable one out
+        ASSERT_TRUE(slots.rebuildIndex());
+        ASSERT_EQ(slots.size(), 0u);
+    }
+
+    TEST_F(SaveSlotsTest, RebuildMissingOrCorruptIndex)
+    {
+        WriteOptions options;
+        options.encryption = false;
+        std::int64_t savedAt = 0;
+        {
+            SaveSlots slots;
+            ASSERT_TRUE(slots.open(m_directory, options));
+            ASSERT_TRUE(slots.save("a", GameData("PlayerA", 1)));
+            ASSERT_TRUE(slots.save("b", GameData("PlayerB", 2)));
+            savedAt = slots.info("b").value().timestamp;
+        }
+
+        std::filesystem::remove(pathOf(SaveSlots::INDEX_FILENAME));
+        {
+            SaveSlots slots;
+            ASSERT_TRUE(slots.open(m_directory, options));
+            ASSERT_EQ(slots.size(), 2u);
+            ASSERT_EQ(slots.info("b").value().nickname, "PlayerB");
+            ASSERT_EQ(slots.info("b").value().timestamp, savedAt) << "a rebuild keeps the time the slot was saved";
+            ASSERT_TRUE(std::filesystem::exists(pathOf(SaveSlots::INDEX_FILENAME)));
+        }
+
+        writeFile(pathOf(SaveSlots::INDEX_FILENAME), "{\"version\":1,\"slots\":[{\"name\":");
+        {
+            SaveSlots slots;
+            ASSERT_TRUE(slots.open(m_directory, options));
+            ASSERT_EQ(slots.size(), 2u);
+            ASSERT_EQ(slots.info("a").value().highscore, 1);
+        }
+    }
+
+    TEST_F(SaveSlotsTest, IndexIsEncryptedWithTheSlots)
+    {
+        auto readIndex = [this]()
+        {
+            std::ifstream file(pathOf(SaveSlots::INDEX_FILENAME), std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        };
+
+        WriteOptions plain;
+        plain.encryption = false;
+        {
+            SaveSlots slots;
+            ASSERT_TRUE(slots.open(m_directory, plain));
+            ASSERT_TRUE(slots.save("secret", GameData("HiddenNickname", 4242)));
+            ASSERT_NE(readIndex().find("HiddenNickname"), std::string::npos) << "Unencrypted slots keep a readable index";
+        }
+
+        // Opening with encryption seals the index right away, before any save
+        {
+            SaveSlots slots;
+            ASSERT_TRUE(slots.open(m_directory));
+            ASSERT_TRUE(slots.save("secret", GameData("HiddenNickname", 4242)));
+        }
+        std::string index = readIndex();
+        ASSERT_EQ(index.find("HiddenNickname"), std::string::npos);
+        ASSERT_EQ(index.find("4242"), std::string::npos);
+        ASSERT_EQ(index.find("highscore"), std::string::npos);
+
+        SaveSlots reopened;
+        ASSERT_TRUE(reopened.open(m_directory));
+        ASSERT_EQ(reopened.info("secret").value().nickname, "HiddenNickname");
+        ASSERT_EQ(reopened.info("secret").value().highscore, 4242);
+
+        // A tampered index fails authentication and is rebuilt from the slot files
+        index.back() ^= 0x01;
+        writeFile(pathOf(SaveSlots::INDEX_FILENAME), index);
+        SaveSlots rebuilt;
+        ASSERT_TRUE(rebuilt.open(m_directory));
+        ASSERT_EQ(rebuilt.info("secret").value().nickname, "HiddenNickname");
+        ASSERT_EQ(readIndex().find("HiddenNickname"), std::string::npos);
+
+        // and turning encryption off stores it readable again
+        SaveSlots unsealed;
+        ASSERT_TRUE(unsealed.open(m_directory, plain));
+        ASSERT_EQ(unsealed.info("secret").value().highscore, 4242);
+        ASSERT_NE(readIndex().find("HiddenNickname"), std::string::npos);
+    }
+
+    TEST_F(SaveSlotsTest, RepairAfterCrashBetweenSlotAndIndex)
+    {
+        {
+            SaveSlots slots;
+            ASSERT_TRUE(slots.open(m_directory));
+            ASSERT_TRUE(slots.save("crashy", GameData("BeforeCrash", 1)));
+            ASSERT_TRUE(slots.save("other", GameData("Untouched", 5)));
+        }
+
+        // What a crash after the slot write but before the index write leaves behind
+        writeFile(pathOf(SaveSlots::PENDING_FILENAME), "crashy");
+        ASSERT_TRUE(DataReaderWriter::writeData(GameData("AfterCrash", 2), pathOf("crashy.sav")));
+
+        SaveSlots slots;
+        ASSERT_TRUE(slots.open(m_directory));
+        ASSERT_EQ(slots.info("crashy").value().nickname, "AfterCrash");
+        ASSERT_EQ(slots.info("crashy").value().highscore, 2);
+        ASSERT_EQ(slots.info("crashy").value().size, std::filesystem::file_size(pathOf("crashy.sav")));
+        ASSERT_EQ(slots.info("other").value().nickname, "Untouched");
+        ASSERT_FALSE(std::filesystem::exists(pathOf(SaveSlots::PENDING_FILENAME)));
+
+        // The same for an interrupted remove
+        writeFile(pathOf(SaveSlots::PENDING_FILENAME), "other");
+        std::filesystem::remove(pathOf("other.sav"));
+        SaveSlots afterRemove;
+        ASSERT_TRUE(afterRemove.open(m_directory));
+        ASSERT_FALSE(afterRemove.info("other").has_value());
+        ASSERT_EQ(afterRemove.size(), 1u);
+    }
+
+    TEST_F(SaveSlotsTest, InvalidSlotNames)
+    {
+        SaveSlots slots;
+        ASSERT_TRUE(slots.open(m_directory));
+
+        for (const std::string name : {"", "../escape", "with space", "dir/slot", "slot.sav"})
+        {
+            ASSERT_FALSE(SaveSlots::isValidName(name)) << name;
+            ASSERT_FALSE(slots.save(name, GameData("Invalid", 1))) << name;
+            ASSERT_FALSE(slots.load(name).has_value()) << name;
+        }
+        ASSERT_TRUE(SaveSlots::isValidName("Profile_1-auto"));
+        ASSERT_EQ(slots.size(), 0u);
+    }
+} // namespace datacoe
\ No newline at end of file
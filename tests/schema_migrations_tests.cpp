@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include <datacoe/schema_migrations.hpp>
+#include <datacoe/data_manager.hpp>
+#include <datacoe/data_reader_writer.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace datacoe
+{
+    class SchemaMigrationsTest : public ::testing::Test
+    {
+    protected:
+        std::string m_directory;
+
+        void SetUp() override
+        {
+            m_directory = "test_schema_migrations";
+            std::error_code ec;
+            std::filesystem::remove_all(m_directory, ec);
+            std::filesystem::create_directories(m_directory);
+        }
+
+        void TearDown() override
+        {
+            SchemaMigrations::reset();
+            std::error_code ec;
+            std::filesystem::remove_all(m_directory, ec);
+        }
+
+        std::string pathOf(const std::string &file) const
+        {
+            return (std::filesystem::path(m_directory) / file).string();
+        }
+
+        void writeFile(const std::string &path, const std::string &contents)
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file << contents;
+        }
+
+        std::string readFile(const std::string &path)
+        {
+            std::ifstream file(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        int schemaVersionOf(const std::string &path)
+        {
+            ReadOptions options;
+            options.decryption = false;
+            SaveInfo info;
+            info.schemaVersion = -1;
+            DataReaderWriter::decode(readFile(path), options, &info);
+            return info.schemaVersion;
+        }
+    };
+
+    TEST_F(SchemaMigrationsTest, SavesRecordTheSchemaVersion)
+    {
+        GameData gd("Versioned", 1);
+        ASSERT_EQ(gd.toJson()[GameData::SCHEMA_VERSION_KEY], GameData::SCHEMA_VERSION);
+
+        std::string path = pathOf("current.json");
+        ASSERT_TRUE(DataReaderWriter::writeData(gd, path, false));
+        ASSERT_EQ(schemaVersionOf(path), GameData::SCHEMA_VERSION);
+
+        // Saves from before schema versions existed are version 0 and still load
+        writeFile(path, R"({"nickname":"Legacy","highscore":7})");
+        ASSERT_EQ(schemaVersionOf(path), 0);
+        ASSERT_EQ(DataReaderWriter::readData(path, false).value(), GameData("Legacy", 7));
+        ASSERT_EQ(GameData::fromJson(json::parse(R"({"nickname":"Legacy","highscore":7})")), GameData("Legacy", 7));
+    }
+
+    TEST_F(SchemaMigrationsTest, StepsRunOnlyForOlderSaves)
+    {
+        int runs = 0;
+        // A step that renamed a field, saves of version 0 called the nickname "name"
+        SchemaMigrations::add(0, [&runs](json &save)
+                              {
+            runs++;
+            if (save.contains("name"))
+            {
+                save["nickname"] = std::move(save["name"]);
+                save.erase("name");
+            } });
+
+        std::string legacy = pathOf("legacy.json");
+        writeFile(legacy, R"({"name":"Renamed","highscore":42})");
+        std::optional<GameData> loaded = DataReaderWriter::readData(legacy, false);
+        ASSERT_TRUE(loaded.has_value());
+        ASSERT_EQ(loaded.value(), GameData("Renamed", 42));
+        ASSERT_EQ(runs, 1);
+
+        // Every format takes the same path
+        json save = json::parse(R"({"name":"Binary","highscore":3})");
+        std::string cbor;
+        json::to_cbor(save, cbor);
+        int version = -1;
+        ASSERT_EQ(GameData::parse(cbor, json::input_format_t::cbor, &version), GameData("Binary", 3));
+        ASSERT_EQ(version, 0);
+        ASSERT_EQ(runs, 2);
+
+        // Up-to-date saves never reach the steps
+        std::string current = pathOf("current.json");
+        for (int i = 0; i < 5; i++)
+        {
+            ASSERT_TRUE(DataReaderWriter::writeData(GameData("Current", i), current));
+            ASSERT_TRUE(DataReaderWriter::readData(current).has_value());
+        }
+        ASSERT_EQ(runs, 2);
+    }
+
+    TEST_F(SchemaMigrationsTest, ChainAndFailures)
+    {
+        std::vector<int> order;
+        for (int from = 0; from < 3; from++)
+            SchemaMigrations::add(from, [&order, from](json &)
+                                  { order.push_back(from); });
+
+        json save = {{"nickname", "Chain"}};
+        SchemaMigrations::migrate(save, 0, 3);
+        ASSERT_EQ(order, (std::vector<int>{0, 1, 2}));
+        ASSERT_EQ(save[GameData::SCHEMA_VERSION_KEY], 3);
+
+        // A gap in the chain is an error
+        ASSERT_THROW(SchemaMigrations::migrate(save, 2, 5), std::runtime_error);
+
+        // reset() restores the steps that ship with the library
+        SchemaMigrations::reset();
+        ASSERT_THROW(SchemaMigrations::migrate(save, 1, 2), std::runtime_error);
+        ASSERT_NO_THROW(SchemaMigrations::migrate(save, 0, 1));
+
+        // A failing step, a newer version and an invalid version make the save unreadable
+        SchemaMigrations::add(0, [](json &)
+                              { throw std::runtime_error("step failed"); });
+        std::string path = pathOf("unreadable.json");
+        writeFile(path, R"({"nickname":"Fails","highscore":1})");
+        ASSERT_FALSE(DataReaderWriter::readData(path, false).has_value());
+
+        writeFile(path, R"({"nickname":"Future","highscore":1,"schemaVersion":999})");
+        ASSERT_FALSE(DataReaderWriter::readData(path, false).has_value());
+        ASSERT_THROW(GameData::fromJson(json::parse(readFile(path))), std::runtime_error);
+
+        writeFile(path, R"({"nickname":"Invalid","highscore":1,"schemaVersion":"1"})");
+        ASSERT_FALSE(DataReaderWriter::readData(path, false).has_value());
+    }
+
+    TEST_F(SchemaMigrationsTest, UpgradeManyRewritesOldSavesOnce)
+    {
+        int runs = 0;
+        SchemaMigrations::add(0, [&runs](json &)
+                              { runs++; });
+
+        std::vector<std::string> filenames;
+        for (int i = 0; i < 6; i++)
+        {
+            std::string path = pathOf("save" + std::to_string(i) + ".json");
+            if (i % 2 == 0)
+                writeFile(path, R"({"nickname":"Old)" + std::to_string(i) + R"(","highscore":)" + std::to_string(i) + "}");
+            else
+                ASSERT_TRUE(DataReaderWriter::writeData(GameData("New" + std::to_string(i), i), path, false));
+            filenames.push_back(path);
+        }
+        std::string untouched = readFile(filenames[1]);
+        filenames.push_back(pathOf("missing.json"));
+
+        WriteOptions options;
+        options.encryption = false;
+        std::vector<bool> upgraded = DataReaderWriter::upgradeMany(filenames, options, 2);
+        ASSERT_EQ(upgraded, (std::vector<bool>{true, true, true, true, true, true, false}));
+        ASSERT_EQ(runs, 3);
+        ASSERT_EQ(readFile(filenames[1]), untouched);
+
+        // The migration cost was paid once, loads no longer run the steps
+        filenames.pop_back();
+        std::vector<std::optional<GameData>> loaded = DataReaderWriter::readMany(filenames, ReadOptions(), 2);
+        for (std::size_t i = 0; i < filenames.size(); i++)
+        {
+            ASSERT_TRUE(loaded[i].has_value());
+            ASSERT_EQ(loaded[i]->getHighscore(), static_cast<int>(i));
+            ASSERT_EQ(schemaVersionOf(filenames[i]), GameData::SCHEMA_VERSION);
+        }
+        ASSERT_EQ(runs, 3);
+    }
+
+    TEST_F(SchemaMigrationsTest, DataManagerStoresMigratedSave)
+    {
+        std::string path = pathOf("managed.json");
+        writeFile(path, R"({"nickname":"Managed","highscore":10})");
+
+        DataManager dm;
+        ASSERT_TRUE(dm.init(path, false));
+        ASSERT_EQ(dm.getGamedata(), GameData("Managed", 10));
+
+        // Nothing changed, but the file is still in the old schema, so the save is not skipped
+        ASSERT_TRUE(dm.isDirty());
+        ASSERT_TRUE(dm.saveGame());
+        ASSERT_EQ(dm.getSkippedSaveCount(), 0u);
+        ASSERT_EQ(schemaVersionOf(path), GameData::SCHEMA_VERSION);
+
+        ASSERT_TRUE(dm.loadGame());
+        ASSERT_FALSE(dm.isDirty());
+    }
+} // namespace datacoe
\ No newline at end of file